@@ -63,6 +63,9 @@ uint8_t PWM1_LVL;
 #endif
 
 
+// brown-out detection while asleep (BODCFG fuse sets it while awake)
+//#define BOD_SLEEP BOD_SLEEP_SAMPLED_gc  // default is off, see fsm-standby.h
+
 // with so many pins, doing this all with #ifdefs gets awkward...
 // ... so just hardcode it in each hwdef file instead
 inline void hwdef_setup() {
@@ -74,27 +77,27 @@ inline void hwdef_setup() {
     VPORTB.DIR = PIN0_bm | PIN1_bm | PIN5_bm;  // Outputs: Aux LED and PWMs
     //VPORTC.DIR = ...;
 
-    // enable pullups on the unused pins to reduce power
-    PORTA.PIN0CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN1CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN2CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN3CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN4CTRL = PORT_PULLUPEN_bm;
+    // enable pullups and turn off digital input on unused pins to reduce power
+    PORTA.PIN0CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN1CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN2CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN3CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN4CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
     PORTA.PIN5CTRL = PORT_PULLUPEN_bm | PORT_ISC_BOTHEDGES_gc;  // eSwitch
-    PORTA.PIN6CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN7CTRL = PORT_PULLUPEN_bm;
+    PORTA.PIN6CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN7CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
 
     //PORTB.PIN0CTRL = PORT_PULLUPEN_bm; // cold tint channel
     //PORTB.PIN1CTRL = PORT_PULLUPEN_bm; // warm tint channel
-    PORTB.PIN2CTRL = PORT_PULLUPEN_bm;
-    PORTB.PIN3CTRL = PORT_PULLUPEN_bm;
-    PORTB.PIN4CTRL = PORT_PULLUPEN_bm;
+    PORTB.PIN2CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTB.PIN3CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTB.PIN4CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
     //PORTB.PIN5CTRL = PORT_PULLUPEN_bm; // Aux LED
 
-    PORTC.PIN0CTRL = PORT_PULLUPEN_bm;
-    PORTC.PIN1CTRL = PORT_PULLUPEN_bm;
-    PORTC.PIN2CTRL = PORT_PULLUPEN_bm;
-    PORTC.PIN3CTRL = PORT_PULLUPEN_bm;
+    PORTC.PIN0CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTC.PIN1CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTC.PIN2CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTC.PIN3CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
 
     // set up the PWM
     // TODO: add references to MCU documentation
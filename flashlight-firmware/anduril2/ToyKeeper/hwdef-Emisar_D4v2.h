@@ -68,6 +68,11 @@
 #define BUTTON_LED_DDR  DDRA   // for all "PA" pins
 #define BUTTON_LED_PUE  PUEA   // for all "PA" pins
 
+// peripherals used, for the power reduction register (PRR)
+// (PWM on timer 1, ADC for voltage and temperature)
+#define PRR_USED ((1<<PRTIM1) | (1<<PRADC))
+// (for brown-out detection fuses, see hwdef-Noctigon_KR4.h)
+
 // with so many pins, doing this all with #ifdefs gets awkward...
 // ... so just hardcode it in each hwdef file instead
 inline void hwdef_setup() {
@@ -95,8 +100,16 @@ inline void hwdef_setup() {
 
   // set up e-switch
   //PORTA = (1 << SWITCH_PIN);  // TODO: configure PORTA / PORTB / PORTC?
-  PUEA = (1 << SWITCH_PIN);  // pull-up for e-switch
+  PUEA = (1 << SWITCH_PIN)  // pull-up for e-switch
+       | (1 << PA0);  // unused pin, so it doesn't float
   SWITCH_PCMSK = (1 << SWITCH_PCINT);  // enable pin change interrupt
+
+  // other unused pins: turn off digital input where possible,
+  // pull up the rest, so floating inputs don't waste power
+  DIDR0 = (1 << ADC4D);  // PA7
+  DIDR1 = (1 << ADC5D) | (1 << ADC6D) | (1 << ADC7D);  // PB0, PB1, PB2
+  DIDR2 = (1 << ADC9D) | (1 << ADC10D) | (1 << ADC11D);  // PC0, PC1, PC2
+  PUEC = (1 << PC4) | (1 << PC5);
 }
 
 #define LAYOUT_DEFINED
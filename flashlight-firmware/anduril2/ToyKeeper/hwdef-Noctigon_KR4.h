@@ -117,6 +117,17 @@
 #define BUTTON_LED_DDR  DDRA   // for all "PA" pins
 #define BUTTON_LED_PUE  PUEA   // for all "PA" pins
 
+// peripherals used, for the power reduction register (PRR)
+// (PWM on timer 1, ADC for voltage and temperature)
+#define PRR_USED ((1<<PRTIM1) | (1<<PRADC))
+
+// brown-out detection is set only by fuses on the attiny1634:
+//   efuse BODACT (bits 2:1) while awake, BODPD (bits 4:3) while asleep,
+//   each 11 = off, 10 = on, 01 = sampled (BODLEVEL in hfuse sets the level)
+// stock fuses (efuse 0xFF) leave it off both ways, which is cheapest
+// for BOD while awake without ~20uA more standby drain, use efuse 0xFD
+// (off while asleep) or 0xED (sampled while asleep, ~1uA)
+
 // with so many pins, doing this all with #ifdefs gets awkward...
 // ... so just hardcode it in each hwdef file instead
 inline void hwdef_setup() {
@@ -154,6 +165,13 @@ inline void hwdef_setup() {
   //PORTB = (1 << SWITCH_PIN);  // TODO: configure PORTA / PORTB / PORTC?
   PUEB = (1 << SWITCH_PIN);  // pull-up for e-switch
   SWITCH_PCMSK = (1 << SWITCH_PCINT);  // enable pin change interrupt
+
+  // unused pins: turn off digital input where possible, pull up the rest,
+  // so floating inputs don't waste power
+  DIDR0 = (1 << ADC4D);  // PA7
+  DIDR2 = (1 << ADC9D) | (1 << ADC10D) | (1 << ADC11D);  // PC0, PC1, PC2
+  PUEA = (1 << PA0) | (1 << PA1);
+  PUEC = (1 << PC4) | (1 << PC5);
 }
 
 #define LAYOUT_DEFINED
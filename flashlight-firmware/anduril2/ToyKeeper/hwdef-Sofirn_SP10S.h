@@ -79,6 +79,9 @@ ATTINY1616 Mapping:
 
 
 
+// brown-out detection while asleep (BODCFG fuse sets it while awake)
+//#define BOD_SLEEP BOD_SLEEP_SAMPLED_gc  // default is off, see fsm-standby.h
+
 // with so many pins, doing this all with #ifdefs gets awkward...
 // ... so just hardcode it in each hwdef file instead
 inline void hwdef_setup() {
@@ -90,27 +93,28 @@ inline void hwdef_setup() {
     VPORTB.DIR = PIN0_bm | PIN5_bm;  // PWM pins as output
     //VPORTC.DIR = ...;
 
-    // enable pullups on the input pins to reduce power
-    PORTA.PIN0CTRL = PORT_PULLUPEN_bm;
+    // enable pullups and turn off digital input on unused pins to reduce power
+    PORTA.PIN0CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
     //PORTA.PIN1CTRL = PORT_PULLUPEN_bm; // Boost enable pin
-    PORTA.PIN2CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN3CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN4CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN5CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN6CTRL = PORT_PULLUPEN_bm;
-    PORTA.PIN7CTRL = PORT_PULLUPEN_bm;
+    PORTA.PIN2CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN3CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN4CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN5CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN6CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTA.PIN7CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
 
     //PORTB.PIN0CTRL = PORT_PULLUPEN_bm; // Big PWM channel
-    PORTB.PIN1CTRL = PORT_PULLUPEN_bm;
-    PORTB.PIN2CTRL = PORT_PULLUPEN_bm;
+    PORTB.PIN1CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTB.PIN2CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
     PORTB.PIN3CTRL = PORT_PULLUPEN_bm | PORT_ISC_BOTHEDGES_gc;  // Switch
-    //PORTB.PIN4CTRL = PORT_PULLUPEN_bm; // Voltage divider
+    PORTB.PIN4CTRL = PORT_ISC_INPUT_DISABLE_gc; // Voltage divider (analog only)
     //PORTB.PIN5CTRL = PORT_PULLUPEN_bm; // Small PWM channel
 
     //PORTC.PIN0CTRL = PORT_PULLUPEN_bm; connected to the ADC via airwire
-    PORTC.PIN1CTRL = PORT_PULLUPEN_bm;
-    PORTC.PIN2CTRL = PORT_PULLUPEN_bm;
-    PORTC.PIN3CTRL = PORT_PULLUPEN_bm;
+    PORTC.PIN0CTRL = PORT_ISC_INPUT_DISABLE_gc; // (analog only)
+    PORTC.PIN1CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTC.PIN2CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
+    PORTC.PIN3CTRL = PORT_PULLUPEN_bm | PORT_ISC_INPUT_DISABLE_gc;
 
     // set up the PWM
     // TODO: add references to MCU documentation
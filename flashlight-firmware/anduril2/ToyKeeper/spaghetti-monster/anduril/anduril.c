@@ -59,6 +59,12 @@
 #include "tk.h"
 #include incfile(CONFIGFILE)
 
+// build tools can change the config here, after the target sets it up
+// (like bin/feature_cost.py, which turns features off one at a time)
+#ifdef EXTRA_CONFIGFILE
+#include incfile(EXTRA_CONFIGFILE)
+#endif
+
 
 /********* Include headers which need to be before FSM *********/
 
@@ -114,6 +120,10 @@
 #include "version-check-mode.h"
 #endif
 
+#ifdef USE_PERF_COUNTERS
+#include "perf-check-mode.h"
+#endif
+
 #ifdef USE_BATTCHECK_MODE
 #include "battcheck-mode.h"
 #endif
@@ -169,6 +179,10 @@
 #include "version-check-mode.c"
 #endif
 
+#ifdef USE_PERF_COUNTERS
+#include "perf-check-mode.c"
+#endif
+
 #ifdef USE_BATTCHECK_MODE
 #include "battcheck-mode.c"
 #endif
@@ -278,6 +292,12 @@ void loop() {
     }
     #endif
 
+    #ifdef USE_PERF_COUNTERS
+    else if (state == perf_check_state) {
+        perf_check_iter();
+    }
+    #endif
+
     #ifdef USE_STROBE_STATE
     else if ((state == strobe_state)
          #ifdef USE_MOMENTARY_MODE
@@ -297,6 +317,15 @@ void loop() {
 
     #ifdef USE_BATTCHECK
     else if (state == battcheck_state) {
+        #ifdef USE_ENERGY_METER
+        if (battcheck_readout == BATTCHECK_RUNTIME)
+            blink_big_num(runtime_minutes(memorized_level));
+        else if (battcheck_readout == BATTCHECK_MAH)
+            blink_big_num(energy_mah);
+        else if (battcheck_readout == BATTCHECK_MWH)
+            blink_big_num(energy_mwh);
+        else
+        #endif
         battcheck();
         #ifdef USE_SIMPLE_UI
         // in simple mode, turn off after one readout
@@ -357,15 +386,23 @@ void low_voltage() {
     #endif
 
     // in normal mode, step down or turn off
+    // (with USE_SMOOTH_LVP, steady_state handles its own LVP)
+    #ifndef USE_SMOOTH_LVP
     else if (state == steady_state) {
         if (actual_level > 1) {
+            #ifdef USE_ENERGY_METER
+            // cut current by 25% (and glide there, instead of jumping)
+            lvp_glide_to(lvp_stepdown(4));
+            #else
             uint8_t lvl = (actual_level >> 1) + (actual_level >> 2);
             set_level_and_therm_target(lvl);
+            #endif
         }
         else {
             set_state(off_state, 0);
         }
     }
+    #endif
     // all other modes, just turn off when voltage is low
     else {
         set_state(off_state, 0);
@@ -373,3 +410,16 @@ void low_voltage() {
 
 }
 
+#ifdef USE_SMOOTH_LVP
+// the battery is empty, so turn off right away, whatever the light is
+// doing  (never step down to some other mode, like low_voltage() does)
+void lvp_hard_cutoff() {
+    set_level(0);
+    #ifdef USE_LOCKOUT_MODE
+    // already off, so don't unlock
+    if (current_state == lockout_state) return;
+    #endif
+    set_state(off_state, 0);
+}
+#endif
+
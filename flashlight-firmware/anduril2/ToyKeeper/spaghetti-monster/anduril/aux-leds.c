@@ -42,34 +42,74 @@ void indicator_blink(uint8_t arg) {
     #else
 
     // fancy blink, set off/low/high levels here:
-    static const uint8_t seq[] = {0, 1, 2, 1,  0, 0, 0, 0,
-                                  0, 0, 1, 0,  0, 0, 0, 0};
-    indicator_led(seq[arg & 15]);
+    static const PROGMEM uint8_t seq[] = {0, 1, 2, 1,  0, 0, 0, 0,
+                                          0, 0, 1, 0,  0, 0, 0, 0};
+    indicator_led(pgm_read_byte(seq + (arg & 15)));
 
     #endif  // ifdef USE_OLD_BLINKING_INDICATOR
 }
 #endif
 
+#if (defined(USE_AUX_RGB_LEDS) || defined(USE_BUTTON_LED)) && defined(TICK_DURING_STANDBY)
+// brightness for each frame of the "blinking" pattern (0=off, 1=low, 2=high)
+// uses an odd length to avoid lining up with rainbow loop
+static const PROGMEM uint8_t aux_blink_frames[] = {
+    2, 1, 0, 0,  0, 0, 0, 0,  0,
+    1, 0, 0, 0,  0, 0, 0, 0,  0, 1,
+};
+
+// pattern 0bPPPP (off, low, high, blinking) -> brightness for this tick
+// (frame is the caller's own animation state, advanced only while blinking)
+static uint8_t aux_led_level(uint8_t pattern, uint8_t *frame) {
+    // preview in blinking mode is awkward... use high instead
+    if (pattern > 2) {
+        if (! go_to_standby) return 2;
+        uint8_t f = *frame + 1;
+        if (f >= sizeof(aux_blink_frames)) f = 0;
+        *frame = f;
+        return pgm_read_byte(aux_blink_frames + f);
+    }
+    return pattern;
+}
+#endif
+
 #if defined(USE_AUX_RGB_LEDS) && defined(TICK_DURING_STANDBY)
+// voltage, color
+static const PROGMEM vfine_t voltage_rgb_levels[] = {
+      VFINE(0), 0, // 0, R
+     VFINE(33), 1, // 1, R+G
+     VFINE(35), 2, // 2,   G
+     VFINE(37), 3, // 3,   G+B
+     VFINE(39), 4, // 4,     B
+     VFINE(41), 5, // 5, R + B
+     VFINE(44), 6, // 6, R+G+B  // skip; looks too similar to G+B
+    VFINE(255), 6, // 7, R+G+B
+};
+#ifdef USE_ADC_OVERSAMPLING
+#define pgm_read_vfine pgm_read_word
+#else
+#define pgm_read_vfine pgm_read_byte
+#endif
+
 uint8_t voltage_to_rgb() {
-    static const uint8_t levels[] = {
-    // voltage, color
-          0, 0, // 0, R
-         33, 1, // 1, R+G
-         35, 2, // 2,   G
-         37, 3, // 3,   G+B
-         39, 4, // 4,     B
-         41, 5, // 5, R + B
-         44, 6, // 6, R+G+B  // skip; looks too similar to G+B
-        255, 6, // 7, R+G+B
-    };
-    uint8_t volts = voltage;
-    if (volts < VOLTAGE_LOW) return 0;
-
-    uint8_t i;
-    for (i = 0;  volts >= levels[i];  i += 2) {}
-    uint8_t color_num = levels[(i - 2) + 1];
-    return pgm_read_byte(rgb_led_colors + color_num);
+    // voltage only changes a few times per minute at most,
+    // so remember the answer instead of searching the table every tick
+    static vfine_t last_volts = 0;
+    static uint8_t last_color = 0;  // (0 is also the answer for 0 volts)
+
+    vfine_t volts = voltage_fine;
+    if (volts == last_volts) return last_color;
+    last_volts = volts;
+
+    uint8_t color = 0;
+    if (volts >= VOLTAGE_LOW_FINE) {
+        const vfine_t *level = voltage_rgb_levels;
+        while (volts >= pgm_read_vfine(level)) level += 2;
+        uint8_t color_num = pgm_read_vfine(level - 1);
+        color = pgm_read_byte(rgb_led_colors + color_num);
+    }
+    last_color = color;
+    return color;
 }
 
 // do fancy stuff with the RGB aux LEDs
@@ -90,13 +130,9 @@ void rgb_led_update(uint8_t mode, uint8_t arg) {
         return;
     }
 
-    uint8_t pattern = (mode>>4);  // off, low, high, blinking, ... more?
+    uint8_t level = aux_led_level(mode >> 4, &frame);
     uint8_t color = mode & 0x0f;
 
-    // preview in blinking mode is awkward... use high instead
-    if ((! go_to_standby) && (pattern > 2)) { pattern = 2; }
-
-
     const uint8_t *colors = rgb_led_colors;
     uint8_t actual_color = 0;
     if (color < 7) {  // normal color
@@ -112,14 +148,16 @@ void rgb_led_update(uint8_t mode, uint8_t arg) {
         actual_color = pgm_read_byte(colors + color);
     }
     else if (color == 7) {  // disco
-        rainbow = (rainbow + 1 + pseudo_rand() % 5) % 6;
+        // jump 1 to 5 colors ahead, so it's never the same color twice
+        rainbow += 1 + (pseudo_rand() % 5);
+        if (rainbow >= 6) rainbow -= 6;
         actual_color = pgm_read_byte(colors + rainbow);
     }
     else if (color == 8) {  // rainbow
         uint8_t speed = 0x03;  // awake speed
         if (go_to_standby) speed = RGB_RAINBOW_SPEED;  // asleep speed
         if (0 == (arg & speed)) {
-            rainbow = (rainbow + 1) % 6;
+            if (++rainbow >= 6) rainbow = 0;
         }
         actual_color = pgm_read_byte(colors + rainbow);
     }
@@ -127,10 +165,6 @@ void rgb_led_update(uint8_t mode, uint8_t arg) {
         // show actual voltage while asleep...
         if (go_to_standby) {
             actual_color = voltage_to_rgb();
-            // choose a color based on battery voltage
-            //if (volts >= 38) actual_color = pgm_read_byte(colors + 4);
-            //else if (volts >= 33) actual_color = pgm_read_byte(colors + 2);
-            //else actual_color = pgm_read_byte(colors + 0);
         }
         // ... but during preview, cycle colors quickly
         else {
@@ -138,43 +172,34 @@ void rgb_led_update(uint8_t mode, uint8_t arg) {
         }
     }
 
-    // pick a brightness from the animation sequence
-    if (pattern == 3) {
-        // uses an odd length to avoid lining up with rainbow loop
-        static const uint8_t animation[] = {2, 1, 0, 0,  0, 0, 0, 0,  0,
-                                            1, 0, 0, 0,  0, 0, 0, 0,  0, 1};
-        frame = (frame + 1) % sizeof(animation);
-        pattern = animation[frame];
-    }
-    uint8_t result;
+    // each channel is 2 bits: 0=off, 1=low, 2=high
+    if (! level) actual_color = 0;
+    else if (level > 1) actual_color <<= 1;
+    rgb_led_set(actual_color);
     #ifdef USE_BUTTON_LED
-    uint8_t button_led_result;
+    button_led_set(level);
     #endif
-    switch (pattern) {
-        case 0:  // off
-            result = 0;
-            #ifdef USE_BUTTON_LED
-            button_led_result = 0;
-            #endif
-            break;
-        case 1:  // low
-            result = actual_color;
-            #ifdef USE_BUTTON_LED
-            button_led_result = 1;
-            #endif
-            break;
-        default:  // high
-            result = (actual_color << 1);
-            #ifdef USE_BUTTON_LED
-            button_led_result = 2;
-            #endif
-            break;
+}
+
+#ifdef USE_ADAPTIVE_STANDBY
+void aux_led_wake_in(uint8_t mode, uint8_t arg) {
+    uint8_t pattern = (mode>>4);
+    uint8_t color = mode & 0x0f;
+    if (! pattern) return;  // off, never changes
+    if ((pattern == 3)  // blinking
+        #ifdef USE_K93_LOCKOUT_KLUDGE
+        || (color < 7)
+        #endif
+        || (color == 7)) {  // disco
+        standby_wake_in(1);
     }
-    rgb_led_set(result);
-    #ifdef USE_BUTTON_LED
-    button_led_set(button_led_result);
-    #endif
+    else if (color == 8) {  // rainbow
+        standby_wake_in((RGB_RAINBOW_SPEED + 1) - (arg & RGB_RAINBOW_SPEED));
+    }
+    // solid colors never change,
+    // and voltage only changes after sleep LVP, which wakes up anyway
 }
+#endif
 
 void rgb_led_voltage_readout(uint8_t bright) {
     uint8_t color = voltage_to_rgb();
@@ -196,31 +221,7 @@ void button_led_update(uint8_t mode, uint8_t arg) {
         return;
     }
 
-    uint8_t pattern = (mode>>4);  // off, low, high, blinking, ... more?
-
-    // preview in blinking mode is awkward... use high instead
-    if ((! go_to_standby) && (pattern > 2)) { pattern = 2; }
-    // pick a brightness from the animation sequence
-    if (pattern == 3) {
-        // uses an odd length to avoid lining up with rainbow loop
-        uint8_t animation[] = {2, 1, 0, 0,  0, 0, 0, 0,  0,
-            1, 0, 0, 0,  0, 0, 0, 0,  0, 1};
-        frame = (frame + 1) % sizeof(animation);
-        pattern = animation[frame];
-    }
-    uint8_t button_led_result;
-    switch (pattern) {
-        case 0:  // off
-        button_led_result = 0;
-        break;
-        case 1:  // low
-        button_led_result = 1;
-        break;
-        default:  // high
-        button_led_result = 2;
-        break;
-    }
-    button_led_set(button_led_result);
+    button_led_set(aux_led_level(mode >> 4, &frame));
 }
 
 #endif
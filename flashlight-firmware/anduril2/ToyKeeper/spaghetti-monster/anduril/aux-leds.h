@@ -27,6 +27,10 @@ void indicator_blink(uint8_t arg);
 uint8_t setting_rgb_mode_now = 0;
 void rgb_led_update(uint8_t mode, uint8_t arg);
 void rgb_led_voltage_readout(uint8_t bright);
+#ifdef USE_ADAPTIVE_STANDBY
+// tell the standby loop when an aux LED mode next changes
+void aux_led_wake_in(uint8_t mode, uint8_t arg);
+#endif
 /*
  * 0: R
  * 1: RG
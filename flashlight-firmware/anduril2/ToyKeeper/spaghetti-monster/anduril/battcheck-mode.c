@@ -23,6 +23,14 @@
 #include "battcheck-mode.h"
 
 uint8_t battcheck_state(Event event, uint16_t arg) {
+    #ifdef USE_ENERGY_METER
+    // always start with a voltage readout
+    if (event == EV_enter_state) {
+        battcheck_readout = BATTCHECK_VOLTAGE;
+        return MISCHIEF_MANAGED;
+    }
+    #endif
+
     ////////// Every action below here is blocked in the simple UI //////////
     #ifdef USE_SIMPLE_UI
     if (simple_ui_active) {
@@ -48,6 +56,16 @@ uint8_t battcheck_state(Event event, uint16_t arg) {
         return MISCHIEF_MANAGED;
     }
 
+    #ifdef USE_ENERGY_METER
+    // 3 clicks: next readout (voltage, runtime, mAh used, mWh used)
+    else if (event == EV_3clicks) {
+        battcheck_readout ++;
+        if (battcheck_readout >= BATTCHECK_READOUTS)
+            battcheck_readout = BATTCHECK_VOLTAGE;
+        return MISCHIEF_MANAGED;
+    }
+    #endif
+
     #ifdef USE_VOLTAGE_CORRECTION
     // 7H: voltage config mode
     else if (event == EV_click7_hold) {
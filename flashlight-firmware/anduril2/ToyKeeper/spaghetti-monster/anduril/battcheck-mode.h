@@ -22,6 +22,16 @@
 
 uint8_t battcheck_state(Event event, uint16_t arg);
 
+#ifdef USE_ENERGY_METER
+// what to blink out, 3C goes to the next one
+#define BATTCHECK_VOLTAGE 0
+#define BATTCHECK_RUNTIME 1  // minutes left at the memorized level
+#define BATTCHECK_MAH     2  // used since the battery was charged
+#define BATTCHECK_MWH     3
+#define BATTCHECK_READOUTS 4
+uint8_t battcheck_readout = BATTCHECK_VOLTAGE;
+#endif
+
 #ifdef USE_VOLTAGE_CORRECTION
 void voltage_config_save(uint8_t step, uint8_t value);
 uint8_t voltage_config_state(Event event, uint16_t arg);
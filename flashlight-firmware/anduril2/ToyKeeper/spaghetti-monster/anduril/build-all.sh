@@ -2,6 +2,7 @@
 
 # Usage: build-all.sh [pattern]
 # If pattern given, only build targets which match.
+# (builds one at a time, in place; "make -j" builds in parallel instead)
 
 if [ ! -z "$1" ]; then
   SEARCH="$1"
@@ -9,7 +10,11 @@ fi
 
 UI=anduril
 
-date '+#define VERSION_NUMBER "%Y%m%d"' > version.h
+# (only rewrite version.h when the date changes, so builds made with
+#  "make" don't all need to recompile)
+date '+#define VERSION_NUMBER "%Y%m%d"' > version.h.tmp
+if cmp -s version.h.tmp version.h; then rm -f version.h.tmp
+else mv -f version.h.tmp version.h; fi
 
 PASS=0
 FAIL=0
@@ -111,8 +111,8 @@ uint8_t candle_mode_state(Event event, uint16_t arg) {
         #ifdef USE_SUNSET_TIMER
         if (1 == sunset_timer) {
             brightness = brightness
-                         * ((TICKS_PER_MINUTE>>5) - (sunset_ticks>>5))
-                         / (TICKS_PER_MINUTE>>5);
+                         * (SUNSET_PHASE_MAX - SUNSET_PHASE)
+                         / SUNSET_PHASE_MAX;
         }
         #endif  // ifdef USE_SUNSET_TIMER
 
@@ -12,3 +12,7 @@
 // 65% FET power
 #undef PWM3_LEVELS
 #define PWM3_LEVELS 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,2,3,4,6,7,8,10,11,12,13,15,17,18,20,21,23,25,27,29,31,33,35,38,39,42,44,47,49,52,54,57,60,63,66,69,73,76,79,83,86,90,94,98,102,106,110,115,119,124,129,134,139,144,149,155,160,166
+// approximate battery current (mA) per level, for runtime estimates
+#undef BATT_MA_LEVELS
+// ../../../bin/current_calc.py cfg-emisar-d4sv2-219.h 7135:350 7135:1050 FET:15000
+#define BATT_MA_LEVELS 1,1,3,3,4,4,5,7,7,8,10,11,12,14,15,16,18,23,25,26,27,29,30,33,36,38,41,45,48,52,56,60,65,69,74,78,84,89,95,102,108,115,122,129,137,145,155,163,173,184,195,206,217,229,242,255,269,284,299,316,332,350,399,416,436,453,474,494,519,539,564,589,614,642,667,696,729,758,791,824,861,898,935,972,1013,1058,1099,1145,1194,1244,1293,1346,1400,1507,1560,1613,1720,1773,1827,1933,1987,2040,2093,2200,2307,2360,2467,2520,2627,2733,2840,2947,3053,3160,3267,3427,3480,3640,3747,3907,4013,4173,4280,4440,4600,4760,4920,5080,5293,5453,5613,5827,5987,6200,6413,6627,6840,7053,7267,7533,7747,8013,8280,8547,8813,9080,9347,9667,9933,10253
@@ -2,6 +2,7 @@
 #define MODEL_NUMBER "0133"
 #include "hwdef-Emisar_D4Sv2.h"
 #include "hank-cfg.h"
+#include "mk-cfg.h"
 // ATTINY: 1634
 
 // this light has three aux LED channels: R, G, B
@@ -18,6 +19,9 @@
 #define PWM1_LEVELS 1,1,2,2,3,3,4,5,5,6,7,8,9,10,11,12,13,17,18,19,20,21,22,24,26,28,30,33,35,38,41,44,47,50,54,57,61,65,69,74,79,84,89,94,100,106,113,119,126,134,142,150,158,167,176,186,196,207,218,230,242,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,0
 #define PWM2_LEVELS 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,12,16,21,25,30,35,41,46,52,58,64,71,77,84,92,99,107,115,124,133,142,151,161,172,182,193,205,217,229,242,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,0
 #define PWM3_LEVELS 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3,5,6,8,10,12,14,16,18,20,23,25,27,30,32,35,38,41,44,47,50,53,57,60,64,67,71,75,79,83,87,92,96,101,106,111,116,121,127,132,138,144,150,156,163,169,176,183,190,197,205,213,221,229,237,246,255
+// approximate battery current (mA) per level, for runtime estimates
+// ../../../bin/current_calc.py cfg-emisar-d4sv2.h 7135:350 7135:1050 FET:15000
+#define BATT_MA_LEVELS 1,1,3,3,4,4,5,7,7,8,10,11,12,14,15,16,18,23,25,26,27,29,30,33,36,38,41,45,48,52,56,60,65,69,74,78,84,89,95,102,108,115,122,129,137,145,155,163,173,184,195,206,217,229,242,255,269,284,299,316,332,350,399,416,436,453,474,494,519,539,564,589,614,642,667,696,729,758,791,824,861,898,935,972,1013,1058,1099,1145,1194,1244,1293,1346,1400,1560,1667,1720,1827,1933,2040,2147,2253,2360,2467,2627,2733,2840,3000,3107,3267,3427,3587,3747,3907,4067,4227,4440,4600,4813,4973,5187,5400,5613,5827,6040,6307,6520,6787,7053,7320,7587,7853,8173,8440,8760,9080,9400,9720,10093,10413,10787,11160,11533,11907,12333,12760,13187,13613,14040,14520,15000
 #define MAX_1x7135 62
 #define MAX_Nx7135 93
 #define HALFSPEED_LEVEL 18
@@ -10,3 +10,7 @@
 // 65% FET power
 #undef PWM2_LEVELS
 #define PWM2_LEVELS 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,2,3,4,5,6,7,8,9,10,11,12,13,13,15,16,17,18,19,21,22,23,25,26,27,28,30,32,33,34,36,38,39,41,42,44,46,47,49,51,53,55,57,59,61,63,65,67,69,71,73,75,78,80,82,84,87,90,92,94,97,99,102,104,108,110,113,116,119,121,125,127,130,134,136,140,143,146,149,153,156,159,163,166
+// approximate battery current (mA) per level, for runtime estimates
+#undef BATT_MA_LEVELS
+// ../../../bin/current_calc.py cfg-emisar-d4v2-219.h 7135:350 FET:13000
+#define BATT_MA_LEVELS 1,1,3,3,4,4,5,5,7,8,10,11,12,14,16,18,19,21,23,26,27,30,33,36,40,43,47,49,54,58,62,66,70,75,81,85,91,96,103,108,115,122,128,136,143,151,158,166,174,184,192,202,211,221,231,242,253,264,275,287,298,310,324,336,350,350,400,449,499,548,598,648,697,747,796,846,896,945,995,995,1094,1144,1193,1243,1293,1392,1441,1491,1590,1640,1689,1739,1838,1937,1987,2037,2136,2235,2285,2384,2434,2533,2632,2682,2781,2880,2979,3078,3178,3277,3376,3475,3575,3674,3773,3872,3971,4071,4219,4319,4418,4517,4666,4815,4914,5013,5162,5261,5410,5509,5708,5807,5956,6105,6253,6353,6551,6650,6799,6997,7097,7295,7444,7593,7742,7940,8089,8238,8436,8585
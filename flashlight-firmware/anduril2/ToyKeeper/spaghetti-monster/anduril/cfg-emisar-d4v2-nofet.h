@@ -9,6 +9,10 @@
 #undef PWM1_LEVELS
 #undef PWM2_LEVELS
 #define PWM1_LEVELS 1,1,1,2,2,2,2,3,3,3,3,4,4,5,5,6,6,6,7,8,8,9,9,10,10,11,12,13,13,14,15,16,16,17,18,19,20,21,22,23,23,24,26,27,28,29,30,31,32,33,34,36,37,38,39,41,42,43,45,46,47,49,50,52,53,55,56,58,59,61,62,64,66,67,69,71,72,74,76,78,80,81,83,85,87,89,91,93,95,97,99,101,103,105,107,109,111,113,116,118,120,122,125,127,129,132,134,136,139,141,144,146,148,151,154,156,159,161,164,166,169,172,174,177,180,183,185,188,191,194,197,200,203,205,208,211,214,217,220,223,226,230,233,236,239,242,245,249,252,255
+// approximate battery current (mA) per level, for runtime estimates
+#undef BATT_MA_LEVELS
+// ../../../bin/current_calc.py cfg-emisar-d4v2-nofet.h 7135:350
+#define BATT_MA_LEVELS 1,1,1,3,3,3,3,4,4,4,4,5,5,7,7,8,8,8,10,11,11,12,12,14,14,15,16,18,18,19,21,22,22,23,25,26,27,29,30,32,32,33,36,37,38,40,41,43,44,45,47,49,51,52,54,56,58,59,62,63,65,67,69,71,73,75,77,80,81,84,85,88,91,92,95,97,99,102,104,107,110,111,114,117,119,122,125,128,130,133,136,139,141,144,147,150,152,155,159,162,165,167,172,174,177,181,184,187,191,194,198,200,203,207,211,214,218,221,225,228,232,236,239,243,247,251,254,258,262,266,270,275,279,281,285,290,294,298,302,306,310,316,320,324,328,332,336,342,346,350
 #undef MAX_1x7135
 #define MAX_1x7135 150
 #undef QUARTERSPEED_LEVEL
@@ -2,6 +2,7 @@
 #define MODEL_NUMBER "0113"
 #include "hwdef-Emisar_D4v2.h"
 #include "hank-cfg.h"
+#include "mk-cfg.h"
 // ATTINY: 1634
 
 // this light has three aux LED channels: R, G, B
@@ -23,6 +24,9 @@
 #define RAMP_LENGTH 150
 #define PWM1_LEVELS 1,1,2,2,3,3,4,4,5,6,7,8,9,10,12,13,14,15,17,19,20,22,24,26,29,31,34,36,39,42,45,48,51,55,59,62,66,70,75,79,84,89,93,99,104,110,115,121,127,134,140,147,154,161,168,176,184,192,200,209,217,226,236,245,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,0
 #define PWM2_LEVELS 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,3,4,5,7,8,9,11,12,14,15,17,19,20,22,24,25,27,29,31,33,35,37,39,41,43,45,48,50,52,55,57,59,62,64,67,70,72,75,78,81,84,87,90,93,96,99,102,105,109,112,115,119,122,126,129,133,137,141,144,148,152,156,160,165,169,173,177,182,186,191,195,200,205,209,214,219,224,229,234,239,244,250,255
+// approximate battery current (mA) per level, for runtime estimates
+// ../../../bin/current_calc.py cfg-emisar-d4v2.h 7135:350 FET:13000
+#define BATT_MA_LEVELS 1,1,3,3,4,4,5,5,7,8,10,11,12,14,16,18,19,21,23,26,27,30,33,36,40,43,47,49,54,58,62,66,70,75,81,85,91,96,103,108,115,122,128,136,143,151,158,166,174,184,192,202,211,221,231,242,253,264,275,287,298,310,324,336,350,350,400,499,548,598,697,747,796,896,945,1045,1094,1193,1293,1342,1441,1541,1590,1689,1789,1888,1987,2086,2185,2285,2384,2483,2582,2731,2830,2930,3078,3178,3277,3426,3525,3674,3823,3922,4071,4219,4368,4517,4666,4815,4964,5112,5261,5410,5559,5757,5906,6055,6253,6402,6601,6749,6948,7146,7345,7494,7692,7890,8089,8287,8535,8734,8932,9131,9379,9577,9825,10024,10272,10520,10718,10966,11214,11462,11710,11958,12206,12454,12752,13000
 #define MAX_1x7135 65
 #define HALFSPEED_LEVEL 14
 #define QUARTERSPEED_LEVEL 6
@@ -10,4 +10,8 @@
 // 60% FET power
 #undef PWM2_LEVELS
 #define PWM2_LEVELS 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,6,12,18,25,32,38,45,53,60,68,75,83,91,99,108,117,125,135,144,153
+// approximate battery current (mA) per level, for runtime estimates
+#undef BATT_MA_LEVELS
+// ../../../bin/current_calc.py cfg-noctigon-kr4-219.h 7135:4500 FET:11000
+#define BATT_MA_LEVELS 0,0,0,1,1,1,1,2,2,2,3,3,4,4,5,6,6,7,8,9,10,12,13,14,16,18,19,21,23,26,28,31,34,37,40,43,47,51,55,59,64,69,74,80,86,92,99,106,113,121,130,138,148,157,167,178,190,201,214,227,241,256,272,288,308,335,353,371,388,406,424,459,476,494,529,547,565,600,635,653,688,724,759,794,829,865,900,935,988,1024,1076,1112,1165,1218,1271,1324,1376,1429,1482,1553,1606,1676,1747,1818,1888,1959,2029,2100,2188,2276,2347,2435,2524,2629,2718,2806,2912,3018,3124,3229,3335,3459,3582,3706,3829,3953,4076,4218,4359,4500,4653,4806,4959,5137,5316,5469,5647,5851,6029,6233,6412,6616,6820,7024,7253,7482,7686,7941,8171,8400
 
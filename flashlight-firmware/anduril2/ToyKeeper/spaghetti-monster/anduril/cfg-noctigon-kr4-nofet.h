@@ -20,6 +20,10 @@
 #undef PWM2_LEVELS
 #undef PWM_TOPS
 #define PWM_TOPS 16383,16383,12404,8140,11462,14700,11041,12947,13795,14111,14124,13946,13641,13248,12791,13418,12808,13057,12385,12428,12358,12209,12000,11746,11459,11147,11158,10793,10708,10576,10173,9998,9800,9585,9527,9278,9023,8901,8634,8486,8216,8053,7881,7615,7440,7261,7009,6832,6656,6422,6196,6031,5819,5615,5419,5190,4973,4803,4571,4386,4179,3955,3745,3549,3340,3145,2940,2729,2513,2312,2109,1903,1697,1491,1286,1070,871,662,459,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255
+// approximate battery current (mA) per level, for runtime estimates
+#undef BATT_MA_LEVELS
+// ../../../bin/current_calc.py cfg-noctigon-kr4-nofet.h 7135:4500
+#define BATT_MA_LEVELS 0,0,0,1,1,1,1,1,2,2,2,3,3,3,4,4,5,6,6,7,8,8,9,10,11,13,14,15,16,18,19,21,23,25,27,29,31,34,36,39,42,45,49,52,56,59,64,68,72,77,82,87,93,99,105,111,118,125,132,140,148,156,165,174,183,193,204,214,226,237,250,262,276,290,304,320,336,353,373,388,406,441,459,476,494,512,529,565,582,600,635,653,688,706,741,759,794,829,865,900,935,971,1006,1041,1076,1112,1165,1200,1235,1288,1341,1376,1429,1482,1535,1588,1641,1694,1747,1818,1871,1941,1994,2065,2135,2206,2276,2347,2418,2506,2576,2665,2735,2824,2912,3000,3088,3194,3282,3388,3476,3582,3688,3794,3918,4024,4129,4253,4376,4500
 #undef DEFAULT_LEVEL
 #define DEFAULT_LEVEL 50
 #undef MAX_1x7135
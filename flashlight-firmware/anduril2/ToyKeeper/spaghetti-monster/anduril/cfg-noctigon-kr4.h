@@ -3,6 +3,7 @@
 #define MODEL_NUMBER "0211"
 #include "hwdef-Noctigon_KR4.h"
 #include "hank-cfg.h"
+#include "mk-cfg.h"
 // ATTINY: 1634
 
 // this light has three aux LED channels: R, G, B
@@ -32,6 +33,9 @@
 #define PWM1_LEVELS 0,1,1,2,2,3,4,5,6,7,8,9,11,12,14,16,17,19,22,24,26,29,31,34,37,40,43,46,49,53,56,60,63,67,71,74,78,82,86,89,93,96,99,103,105,108,110,112,114,115,116,116,115,114,112,109,106,101,95,89,81,71,60,48,34,19,20,21,22,23,24,26,27,28,30,31,32,34,36,37,39,41,43,45,47,49,51,53,56,58,61,63,66,69,72,75,78,81,84,88,91,95,99,103,107,111,115,119,124,129,133,138,143,149,154,159,165,171,177,183,189,196,203,210,217,224,231,239,247,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,0
 #define PWM2_LEVELS 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,9,20,30,41,52,63,75,87,99,112,125,138,151,165,179,194,208,224,239,255
 #define PWM_TOPS 16383,16383,11750,14690,9183,12439,13615,13955,13877,13560,13093,12529,13291,12513,12756,12769,11893,11747,12085,11725,11329,11316,10851,10713,10518,10282,10016,9729,9428,9298,8971,8794,8459,8257,8043,7715,7497,7275,7052,6753,6538,6260,5994,5798,5501,5271,5006,4758,4525,4268,4030,3775,3508,3263,3010,2752,2517,2256,1998,1763,1512,1249,994,749,497,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255
+// approximate battery current (mA) per level, for runtime estimates
+// ../../../bin/current_calc.py cfg-noctigon-kr4.h 7135:4500 FET:11000
+#define BATT_MA_LEVELS 0,0,0,1,1,1,1,2,2,2,3,3,4,4,5,6,6,7,8,9,10,12,13,14,16,18,19,21,23,26,28,31,34,37,40,43,47,51,55,59,64,69,74,80,86,92,99,106,113,121,130,138,148,157,167,178,190,201,214,227,241,256,272,288,308,335,353,371,388,406,424,459,476,494,529,547,565,600,635,653,688,724,759,794,829,865,900,935,988,1024,1076,1112,1165,1218,1271,1324,1376,1429,1482,1553,1606,1676,1747,1818,1888,1959,2029,2100,2188,2276,2347,2435,2524,2629,2718,2806,2912,3018,3124,3229,3335,3459,3582,3706,3829,3953,4076,4218,4359,4500,4729,5010,5265,5545,5825,6106,6412,6718,7024,7355,7686,8018,8349,8706,9063,9445,9802,10210,10592,11000
 // less ripple, but lows are a bit higher than ideal:
 // maxreg at 130, dynamic PWM: level_calc.py 5.01 2 149 7135 1 0.3 1740 FET 1 10 3190 --pwm dyn:64:4096:255
 // (plus one extra level at the beginning for moon)
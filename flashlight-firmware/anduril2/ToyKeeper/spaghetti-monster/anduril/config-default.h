@@ -195,4 +195,72 @@
 // those oscillations
 //#define USE_LOWPASS_WHILE_ASLEEP
 
+// estimate the battery's internal resistance, and use the estimated
+// open-circuit voltage for LVP, battcheck, and aux LED voltage colors
+// (avoids stepping down early on a good cell which just sags at high power)
+//#define USE_BATT_IR_COMPENSATION
+
+// count mAh / mWh used, and estimate remaining runtime
+// (needs a BATT_MA_LEVELS table in the cfg, from bin/current_calc.py)
+//#define USE_ENERGY_METER
+
+// predictive LVP: in ramp mode, glide down gradually to keep the battery
+// just above the cutoff, then hold at LVP_RESERVE_LEVEL until empty
+// (instead of big sudden steps)
+//#define USE_SMOOTH_LVP
+
+// measure voltage in bursts of 16 samples plus a slow lowpass filter,
+// for a steady reading in 0.01V units (voltage_cv)
+// (adds a hundredths digit to battcheck with USE_EXTRA_BATTCHECK_DIGIT)
+//#define USE_ADC_OVERSAMPLING
+//#define USE_EXTRA_BATTCHECK_DIGIT
+
+// take standby voltage measurements in ADC sleep mode (CPU halted),
+// and turn the ADC off right after, instead of leaving it on for a tick
+//#define USE_ADC_SLEEP
+
+// while off / locked, only wake up as often as the aux LEDs, timers,
+// and sleep LVP actually need, instead of every standby tick
+//#define USE_ADAPTIVE_STANDBY
+
+// get to first light sooner after power is connected:
+// read the config as one block with no power-settle delay,
+// and start the ADC after setup() instead of before it
+// (matters most with START_AT_MEMORIZED_LEVEL, where the tailcap is the UI)
+//#define USE_FAST_BOOT
+
+// when a button press wakes the light from standby, handle it right away
+// instead of on the next clock tick, and start the ADC after the light
+// is on (so "instant on" from off is a tick sooner)
+//#define USE_FAST_WAKE
+
+// count real seconds across awake time and standby, and use that for
+// autolock, the manual memory timer, and the sunset timer
+// (instead of counting ticks, which breaks if the tick speed changes,
+//  and overflows after 145 minutes of standby)
+//#define USE_SECONDS_CLOCK
+
+// debugging: timing probes at the start and end of each ISR and hot path,
+// in a RAM trace ring for bin/fsm-sim.c, and / or on a spare pin
+// (PROBE_PIN, PROBE_PORT, PROBE_DDR) for a logic analyzer
+// (see fsm-probe.h, and "make BUILD=build-probes CPPFLAGS=-DUSE_PROBES")
+//#define USE_PROBES
+
+// debugging: count event queue overflows, late / merged clock ticks,
+// awake / idle / standby ticks, LVP / thermal events, and interrupts
+// (14 clicks from off blinks them out and saves them to the end of
+//  EEPROM, for bin/perf_decode.py; costs 30 bytes of RAM and EEPROM)
+//#define USE_PERF_COUNTERS
+
+// keep lifetime usage totals in the spare EEPROM after the config:
+// time per quarter of the ramp, turbo and thermal step-down time,
+// boots, LVP events, max temperature, and min voltage
+// (saved when going into standby, read with bin/telemetry_decode.py)
+//#define USE_TELEMETRY
+
+// debugging: log every event the UI handles and every state change
+// to a RAM ring, for recording and replaying UI behavior in simavr
+// (see bin/ui_trace.py, which builds with this on by itself)
+//#define USE_EVENT_TRACE
+
 #endif
@@ -103,9 +103,25 @@ typedef enum {
 } eeprom_indexes_e;
 #define EEPROM_BYTES eeprom_indexes_e_END
 
-#ifdef START_AT_MEMORIZED_LEVEL
+// things which get saved often, so they go in the wear-levelled area
+#if defined(START_AT_MEMORIZED_LEVEL) || defined(USE_ENERGY_METER)
 #define USE_EEPROM_WL
-#define EEPROM_WL_BYTES 1
+typedef enum {
+    #ifdef START_AT_MEMORIZED_LEVEL
+    memorized_level_wl_e,
+    #endif
+    #ifdef USE_ENERGY_METER
+    energy_mah_lo_wl_e,
+    energy_mah_hi_wl_e,
+    energy_mwh_lo_wl_e,
+    energy_mwh_hi_wl_e,
+    energy_start_mah_lo_wl_e,
+    energy_start_mah_hi_wl_e,
+    energy_voltage_wl_e,
+    #endif
+    eeprom_wl_indexes_e_END
+} eeprom_wl_indexes_e;
+#define EEPROM_WL_BYTES eeprom_wl_indexes_e_END
 #endif
 
 
@@ -100,9 +100,17 @@ void load_config() {
         autolock_time = eeprom[autolock_time_e];
         #endif
     }
-    #ifdef START_AT_MEMORIZED_LEVEL
+    #ifdef USE_EEPROM_WL
     if (load_eeprom_wl()) {
-        memorized_level = eeprom_wl[0];
+        #ifdef START_AT_MEMORIZED_LEVEL
+        memorized_level = eeprom_wl[memorized_level_wl_e];
+        #endif
+        #ifdef USE_ENERGY_METER
+        energy_mah = eeprom_wl[energy_mah_lo_wl_e] | (eeprom_wl[energy_mah_hi_wl_e] << 8);
+        energy_mwh = eeprom_wl[energy_mwh_lo_wl_e] | (eeprom_wl[energy_mwh_hi_wl_e] << 8);
+        energy_start_mah = eeprom_wl[energy_start_mah_lo_wl_e] | (eeprom_wl[energy_start_mah_hi_wl_e] << 8);
+        energy_voltage = eeprom_wl[energy_voltage_wl_e];
+        #endif
     }
     #endif
 }
@@ -186,13 +194,36 @@ void save_config() {
     save_eeprom();
 }
 
-#ifdef START_AT_MEMORIZED_LEVEL
+#ifdef USE_EEPROM_WL
 void save_config_wl() {
-    eeprom_wl[0] = memorized_level;
+    #ifdef START_AT_MEMORIZED_LEVEL
+    eeprom_wl[memorized_level_wl_e] = memorized_level;
+    #endif
+    #ifdef USE_ENERGY_METER
+    eeprom_wl[energy_mah_lo_wl_e] = energy_mah;
+    eeprom_wl[energy_mah_hi_wl_e] = energy_mah >> 8;
+    eeprom_wl[energy_mwh_lo_wl_e] = energy_mwh;
+    eeprom_wl[energy_mwh_hi_wl_e] = energy_mwh >> 8;
+    eeprom_wl[energy_start_mah_lo_wl_e] = energy_start_mah;
+    eeprom_wl[energy_start_mah_hi_wl_e] = energy_start_mah >> 8;
+    eeprom_wl[energy_voltage_wl_e] = energy_voltage;
+    #endif
     save_eeprom_wl();
 }
 #endif
 
+#ifdef USE_ENERGY_METER
+// checkpoint the energy counters, but only every few mAh
+// (and only when the battery has been swapped, if they were reset)
+void save_energy() {
+    uint16_t saved = eeprom_wl[energy_mah_lo_wl_e] | (eeprom_wl[energy_mah_hi_wl_e] << 8);
+    if ((energy_mah < saved) || (energy_mah >= saved + ENERGY_CHECKPOINT_MAH)) {
+        energy_checkpoint();
+        save_config_wl();
+    }
+}
+#endif
+
 
 #endif
 
@@ -23,9 +23,12 @@
 // remember stuff even after battery was changed
 void load_config();
 void save_config();
-#ifdef START_AT_MEMORIZED_LEVEL
+#ifdef USE_EEPROM_WL
 void save_config_wl();
 #endif
+#ifdef USE_ENERGY_METER
+void save_energy();
+#endif
 
 
 #endif
@@ -93,6 +93,19 @@ uint8_t lockout_state(Event event, uint16_t arg) {
         button_led_update(button_led_lockout_mode, arg);
         #endif
         #endif
+
+        #ifdef USE_ADAPTIVE_STANDBY
+        // when does the indicator / aux LED pattern change next?
+        #if defined(USE_INDICATOR_LED)
+        if ((indicator_led_mode & 0b00001100) == 0b00001100)
+            standby_wake_in(1);
+        #elif defined(USE_AUX_RGB_LEDS)
+        aux_led_wake_in(rgb_led_lockout_mode, arg);
+        #ifdef USE_BUTTON_LED
+        aux_led_wake_in(button_led_lockout_mode & 0xf0, arg);
+        #endif
+        #endif
+        #endif
         return MISCHIEF_MANAGED;
     }
     #endif
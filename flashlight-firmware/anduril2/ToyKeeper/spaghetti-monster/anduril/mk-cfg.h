@@ -0,0 +1,42 @@
+#ifndef MK_CFG
+#define MK_CFG
+
+// config preferences for this fork's own lights (KR4, D4v2, D4Sv2)
+// (attiny1634, so there's room for features the smaller MCUs can't fit)
+
+// use sag-compensated battery voltage for LVP, battcheck, and aux colors
+#define USE_BATT_IR_COMPENSATION
+
+// track mAh / mWh used, estimate runtime (3C in battcheck),
+// and step down by current instead of by level during LVP
+// (each cfg needs a BATT_MA_LEVELS table from bin/current_calc.py)
+#define USE_ENERGY_METER
+
+// glide down during LVP to hold the voltage just above the cutoff,
+// then stay at moon until the battery is empty
+#define USE_SMOOTH_LVP
+
+// oversampled and filtered voltage, in 0.01V units,
+// and show the hundredths digit in battcheck
+#define USE_ADC_OVERSAMPLING
+#define USE_EXTRA_BATTCHECK_DIGIT
+
+// quieter, lower-power voltage checks while off
+#define USE_ADC_SLEEP
+
+// sleep up to 8s at a time when the aux LEDs aren't animated
+#define USE_ADAPTIVE_STANDBY
+
+// get to first light sooner after power is connected
+#define USE_FAST_BOOT
+
+// respond to the button sooner when waking up from standby
+#define USE_FAST_WAKE
+
+// timers count seconds instead of ticks
+#define USE_SECONDS_CLOCK
+
+// lifetime usage log in spare EEPROM, for diagnosing returned lights
+#define USE_TELEMETRY
+
+#endif  // ifndef MK_CFG
@@ -42,6 +42,9 @@ uint8_t off_state(Event event, uint16_t arg) {
         #ifdef USE_SUNSET_TIMER
         sunset_timer = 0;  // needs a reset in case previous timer was aborted
         #endif
+        #ifdef USE_ENERGY_METER
+        save_energy();
+        #endif
         // sleep while off  (lower power use)
         // (unless delay requested; give the ADC some time to catch up)
         if (! arg) { go_to_standby = 1; }
@@ -65,10 +68,21 @@ uint8_t off_state(Event event, uint16_t arg) {
     #if defined(TICK_DURING_STANDBY)
     // blink the indicator LED, maybe
     else if (event == EV_sleep_tick) {
+        #if defined(USE_SECONDS_CLOCK) && (defined(USE_MANUAL_MEMORY_TIMER) || defined(USE_AUTOLOCK))
+        // measure the long timers in seconds, not in sleep ticks
+        // (no overflow after 145 minutes, and not fooled by slower ticks)
+        uint32_t off_seconds = standby_seconds();
+        uint8_t off_minutes = 255;  // (timers only go up to 255 minutes)
+        if (off_seconds < 255*60UL) off_minutes = (uint16_t)off_seconds / 60;
+        #endif
         #ifdef USE_MANUAL_MEMORY_TIMER
         // reset to manual memory level when timer expires
+        #ifdef USE_SECONDS_CLOCK
+        if (manual_memory && (off_minutes >= manual_memory_timer)) {
+        #else
         if (manual_memory &&
                 (arg >= (manual_memory_timer * SLEEP_TICKS_PER_MINUTE))) {
+        #endif
             memorized_level = manual_memory;
             #ifdef USE_TINT_RAMPING
             tint = manual_memory_tint;
@@ -88,11 +102,51 @@ uint8_t off_state(Event event, uint16_t arg) {
 
         #ifdef USE_AUTOLOCK
             // lock the light after being off for N minutes
+            #ifdef USE_SECONDS_CLOCK
+            if ((autolock_time > 0) && (off_minutes >= autolock_time)) {
+            #else
             uint16_t ticks = autolock_time * SLEEP_TICKS_PER_MINUTE;
             if ((autolock_time > 0)  && (arg > ticks)) {
+            #endif
                 set_state(lockout_state, 0);
             }
         #endif  // ifdef USE_AUTOLOCK
+
+        #ifdef USE_ADAPTIVE_STANDBY
+        // when is the next time anything above needs to happen?
+        #ifdef USE_SECONDS_CLOCK
+        #if defined(USE_MANUAL_MEMORY_TIMER) || defined(USE_AUTOLOCK)
+        // (checking once per minute is close enough for both)
+        uint8_t next_minute = 60 - ((uint16_t)off_seconds % 60);
+        #endif
+        #ifdef USE_MANUAL_MEMORY_TIMER
+        if (manual_memory && (off_minutes < manual_memory_timer))
+            standby_wake_in(next_minute * SLEEP_TICKS_PER_SECOND);
+        #endif
+        #elif defined(USE_MANUAL_MEMORY_TIMER)
+        uint16_t mm_ticks = manual_memory_timer * SLEEP_TICKS_PER_MINUTE;
+        if (manual_memory && (arg < mm_ticks))
+            standby_wake_in(mm_ticks - arg);
+        #endif
+        #ifdef USE_INDICATOR_LED
+        if ((indicator_led_mode & 0b00000011) == 0b00000011)
+            standby_wake_in(1);
+        #elif defined(USE_AUX_RGB_LEDS)
+        aux_led_wake_in(rgb_led_off_mode, arg);
+        #ifdef USE_BUTTON_LED
+        aux_led_wake_in(button_led_off_mode & 0xf0, arg);
+        #endif
+        #endif
+        #ifdef USE_AUTOLOCK
+        #ifdef USE_SECONDS_CLOCK
+        if (autolock_time > 0)
+            standby_wake_in(next_minute * SLEEP_TICKS_PER_SECOND);
+        #else
+        if ((autolock_time > 0) && (arg <= ticks))
+            standby_wake_in(ticks + 1 - arg);
+        #endif
+        #endif
+        #endif  // ifdef USE_ADAPTIVE_STANDBY
         return MISCHIEF_MANAGED;
     }
     #endif
@@ -232,6 +286,13 @@ uint8_t off_state(Event event, uint16_t arg) {
         return MISCHIEF_MANAGED;
     }
     #endif
+    #ifdef USE_PERF_COUNTERS
+    // 14 clicks: blink out the performance counters
+    else if (event == EV_14clicks) {
+        set_state(perf_check_state, 0);
+        return MISCHIEF_MANAGED;
+    }
+    #endif
 
     #ifdef USE_SIMPLE_UI
     // 10 clicks, but hold last click: turn simple UI off (or configure it)
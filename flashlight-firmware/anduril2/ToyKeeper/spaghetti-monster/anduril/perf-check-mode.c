@@ -0,0 +1,63 @@
+/*
+ * perf-check-mode.c: Performance counter readout for Anduril.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERF_CHECK_MODE_C
+#define PERF_CHECK_MODE_C
+
+#include "perf-check-mode.h"
+
+// empty state; logic is handled in FSM loop() instead
+uint8_t perf_check_state(Event event, uint16_t arg) {
+    return EVENT_NOT_HANDLED;
+}
+
+// like blink_big_num(), but a zero blinks once (short) instead of nothing
+static uint8_t perf_blink(uint16_t num) {
+    if (num) return blink_big_num(num);
+    if (! blink_digit(0)) return 0;
+    return nice_delay_ms(1000);
+}
+
+// this happens in FSM loop()
+inline void perf_check_iter() {
+    PerfCounters p;
+    perf_snapshot(&p);
+    perf_save(&p);
+
+    // (scale both down until idle * 100 can't overflow, which it would
+    //  after ~8 days awake; idle_ticks is never more than awake_ticks)
+    uint32_t awake = p.awake_ticks;
+    uint32_t idle = p.idle_ticks;
+    while (awake >= (1UL << 25)) { awake >>= 1; idle >>= 1; }
+    uint16_t idle_percent = 0;
+    if (awake)
+        idle_percent = idle * 100 / awake;
+    uint16_t counts[] = {
+        p.queue_max, p.dropped, p.merged_ticks, p.late_ticks,
+        idle_percent, p.lvp_events, p.thermal_events,
+        p.irqs[IRQ_PCINT], p.irqs[IRQ_WDT], p.irqs[IRQ_ADC],
+    };
+    for (uint8_t i=0; i<sizeof(counts)/sizeof(uint16_t); i++) {
+        // stop if the user clicks
+        if (! perf_blink(counts[i])) break;
+    }
+
+    set_state_deferred(off_state, 0);
+}
+
+
+#endif
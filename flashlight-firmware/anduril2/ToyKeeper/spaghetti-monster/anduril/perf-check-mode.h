@@ -0,0 +1,31 @@
+/*
+ * perf-check-mode.h: Performance counter readout for Anduril.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef PERF_CHECK_MODE_H
+#define PERF_CHECK_MODE_H
+
+// blinks out the FSM performance counters (see fsm-perf.h), in order:
+//   queue_max, dropped, merged_ticks, late_ticks,
+//   idle percent (idle_ticks per 100 awake_ticks),
+//   lvp_events, thermal_events,
+//   and interrupts from the button, the clock, and the ADC
+// and saves them to EEPROM, for bin/perf_decode.py
+uint8_t perf_check_state(Event event, uint16_t arg);
+inline void perf_check_iter();
+
+
+#endif
@@ -307,6 +307,38 @@ uint8_t steady_state(Event event, uint16_t arg) {
         return MISCHIEF_MANAGED;
     }
 
+    #ifdef USE_SMOOTH_LVP
+    // battery low: glide down far enough to keep the voltage above the
+    // cutoff, then hold at the reserve level until the battery is empty
+    else if (event == EV_voltage_low) {
+        if (arg == LVP_HARD_CUTOFF) {
+            lvp_hard_cutoff();
+        }
+        else if (! arg) {  // empty
+            #if LVP_RESERVE_LEVEL
+            // (keeps gliding if it's still on the way down)
+            if (actual_level > LVP_RESERVE_LEVEL)
+                lvp_glide_to(LVP_RESERVE_LEVEL);
+            else
+            #endif
+                set_state(off_state, 0);
+        }
+        else if (actual_level > LVP_FLOOR) {
+            uint8_t stepdown = lvp_stepdown(arg);
+            if (stepdown < LVP_FLOOR) stepdown = LVP_FLOOR;
+            // only count warnings which actually lower the level
+            #ifdef USE_SET_LEVEL_GRADUALLY
+            if (stepdown < gradual_target)
+            #else
+            if (stepdown < actual_level)
+            #endif
+                count_lvp_event();
+            lvp_glide_to(stepdown);
+        }
+        return MISCHIEF_MANAGED;
+    }
+    #endif
+
     #ifdef USE_THERMAL_REGULATION
     // overheating: drop by an amount proportional to how far we are above the ceiling
     else if (event == EV_temperature_high) {
@@ -322,6 +354,9 @@ uint8_t steady_state(Event event, uint16_t arg) {
             #else
             set_level_and_therm_target(THERM_FASTER_LEVEL);
             #endif
+            #ifdef USE_TELEMETRY
+            therm_turbo_dropped = 1;
+            #endif
         } else
         #endif
         if (actual_level > MIN_THERM_STEPDOWN) {
@@ -534,6 +569,7 @@ void ramp_extras_config_save(uint8_t step, uint8_t value) {
     // FIXME: should be limited to (65535 / SLEEP_TICKS_PER_MINUTE)
     //   to avoid overflows or impossibly long timeouts
     //   (by default, the effective limit is 145, but it allows up to 255)
+    //   (USE_SECONDS_CLOCK doesn't have this problem)
     else if (2 == step) { manual_memory_timer = value; }
     #endif
 
@@ -638,11 +674,57 @@ void ramp_update_config() {
 void set_level_and_therm_target(uint8_t level) {
     target_level = level;
     set_level(level);
+    #if defined(USE_TELEMETRY) && defined(THERM_HARD_TURBO_DROP)
+    therm_turbo_dropped = 0;  // the user picked a new level
+    #endif
 }
+
+#ifdef USE_TELEMETRY
+uint8_t telemetry_throttled() {
+    if (current_state != steady_state) return 0;
+    #ifdef THERM_HARD_TURBO_DROP
+    if (therm_turbo_dropped) return 1;
+    #endif
+    // thermal step-downs lower the level without changing target_level
+    return (actual_level < target_level);
+}
+#endif
 #else
 #define set_level_and_therm_target(level) set_level(level)
 #endif
 
+#if defined(USE_SMOOTH_LVP) || defined(USE_ENERGY_METER)
+uint8_t lvp_stepdown(uint8_t howmuch) {
+    uint8_t lvl = actual_level;
+    #ifdef USE_SET_LEVEL_GRADUALLY
+    // if it's already gliding down, continue from the target
+    if (gradual_target < lvl) lvl = gradual_target;
+    #endif
+    if (lvl <= 1) return lvl;
+    #ifdef USE_ENERGY_METER
+    // cut current, not levels ... a level is a tiny change at the bottom
+    // of the ramp and a huge one at the top
+    if (howmuch > 16) howmuch = 16;
+    uint16_t ma = batt_ma(lvl);
+    ma -= ((uint32_t)ma * howmuch) >> 4;
+    do { lvl --; } while ((lvl > 1) && (batt_ma(lvl) > ma));
+    #else
+    if (lvl > howmuch) lvl -= howmuch;
+    else lvl = 1;
+    #endif
+    return lvl;
+}
+
+void lvp_glide_to(uint8_t lvl) {
+    #ifdef USE_SET_LEVEL_GRADUALLY
+    set_level_gradually(lvl);
+    target_level = lvl;
+    #else
+    set_level_and_therm_target(lvl);
+    #endif
+}
+#endif
+
 
 #endif
 
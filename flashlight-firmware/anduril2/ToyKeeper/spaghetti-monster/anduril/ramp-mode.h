@@ -147,11 +147,37 @@ void ramp_update_config();
 // brightness before thermal step-down
 uint8_t target_level = 0;
 void set_level_and_therm_target(uint8_t level);
+#if defined(USE_TELEMETRY) && defined(THERM_HARD_TURBO_DROP)
+// turbo was cut to THERM_FASTER_LEVEL, which also lowers target_level
+uint8_t therm_turbo_dropped = 0;
+#endif
 #else
 #define set_level_and_therm_target(level) set_level(level)
 #endif
 
 
+#ifdef USE_SMOOTH_LVP
+// LVP glides down to this level, stays there until the battery is empty,
+// then shuts off  (0 = no reserve stage)
+#ifndef LVP_RESERVE_LEVEL
+#define LVP_RESERVE_LEVEL 1
+#endif
+#if LVP_RESERVE_LEVEL
+#define LVP_FLOOR LVP_RESERVE_LEVEL
+#else
+#define LVP_FLOOR 1
+#endif
+#endif
+
+#if defined(USE_SMOOTH_LVP) || defined(USE_ENERGY_METER)
+// where LVP should step down to from the current level (or from where
+// it's already gliding to) ... with the energy meter, that's howmuch/16
+// less battery current, otherwise howmuch fewer levels
+uint8_t lvp_stepdown(uint8_t howmuch);
+// glide down to a level, for LVP
+void lvp_glide_to(uint8_t lvl);
+#endif
+
 // brightness control
 uint8_t memorized_level = DEFAULT_LEVEL;
 #ifdef USE_MANUAL_MEMORY
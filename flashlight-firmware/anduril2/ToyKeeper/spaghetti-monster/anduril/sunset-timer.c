@@ -32,7 +32,12 @@ uint8_t sunset_timer_state(Event event, uint16_t arg) {
     // reset on start
     if (event == EV_enter_state) {
         sunset_timer = 0;
+        #ifdef USE_SECONDS_CLOCK
+        sunset_seconds = 0;
+        sunset_last_second = clock_seconds;
+        #else
         sunset_ticks = 0;
+        #endif
         return MISCHIEF_MANAGED;
     }
     // hold: maybe "bump" the timer if it's active and almost expired
@@ -50,7 +55,13 @@ uint8_t sunset_timer_state(Event event, uint16_t arg) {
                 // add a few minutes to the timer
                 sunset_timer += SUNSET_TIMER_UNIT;
                 sunset_timer_peak = sunset_timer;  // reset ceiling
-                sunset_ticks = 0;  // reset phase
+                // reset phase
+                #ifdef USE_SECONDS_CLOCK
+                sunset_seconds = 0;
+                sunset_last_second = clock_seconds;
+                #else
+                sunset_ticks = 0;
+                #endif
                 // let the user know something happened
                 blink_once();
             }
@@ -60,10 +71,19 @@ uint8_t sunset_timer_state(Event event, uint16_t arg) {
     // tick: count down until time expires
     else if (event == EV_tick) {
         // time passed
+        #ifdef USE_SECONDS_CLOCK
+        uint8_t now = clock_seconds;
+        sunset_seconds += (uint8_t)(now - sunset_last_second);
+        sunset_last_second = now;
+        // did we reach a minute mark?
+        if (sunset_seconds >= 60) {
+            sunset_seconds -= 60;
+        #else
         sunset_ticks ++;
         // did we reach a minute mark?
         if (sunset_ticks >= TICKS_PER_MINUTE) {
             sunset_ticks = 0;
+        #endif
             if (sunset_timer > 0) {
                 sunset_timer --;
             }
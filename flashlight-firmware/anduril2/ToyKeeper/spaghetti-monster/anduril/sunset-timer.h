@@ -28,7 +28,18 @@
 // automatic shutoff timer
 uint8_t sunset_timer = 0;  // minutes remaining in countdown
 uint8_t sunset_timer_peak = 0;  // total minutes in countdown
+#ifdef USE_SECONDS_CLOCK
+// counts real seconds, so it stays accurate if the tick rate changes
+uint8_t sunset_seconds = 0;  // counts from 0 to 60, then repeats
+uint8_t sunset_last_second = 0;  // low byte of clock_seconds at last tick
+// how far into the current minute, out of SUNSET_PHASE_MAX
+#define SUNSET_PHASE sunset_seconds
+#define SUNSET_PHASE_MAX 60
+#else
 uint16_t sunset_ticks = 0;  // counts from 0 to TICKS_PER_MINUTE, then repeats
+#define SUNSET_PHASE (sunset_ticks>>5)
+#define SUNSET_PHASE_MAX (TICKS_PER_MINUTE>>5)
+#endif
 uint8_t sunset_timer_state(Event event, uint16_t arg);
 
 
@@ -20,6 +20,10 @@
 #ifndef FSM_ADC_C
 #define FSM_ADC_C
 
+#ifdef USE_ADC_SLEEP
+#include <avr/sleep.h>
+#endif
+
 // override onboard temperature sensor definition, if relevant
 #ifdef USE_EXTERNAL_TEMP_SENSOR
 #ifdef ADMUX_THERM
@@ -39,12 +43,16 @@ static inline void set_admux_therm() {
         ADMUXB = ADMUXB_THERM;
     #elif defined(AVRXMEGA3)  // ATTINY816, 817, etc
         ADC0.MUXPOS = ADC_MUXPOS_TEMPSENSE_gc;  // read temperature
-        ADC0.CTRLC = ADC_SAMPCAP_bm | ADC_PRESC_DIV64_gc | ADC_REFSEL_INTREF_gc; // Internal ADC reference
+        ADC0.CTRLC = ADC_SAMPCAP_bm | ADC_PRESC_NOW | ADC_REFSEL_INTREF_gc; // Internal ADC reference
     #else
         #error Unrecognized MCU type
     #endif
     adc_channel = 1;
     adc_sample_count = 0;  // first result is unstable
+    #ifdef USE_ADC_OVERSAMPLING
+    adc_accum[1] = 0;
+    adc_burst_count = 0;
+    #endif
     ADC_start_measurement();
 }
 
@@ -73,16 +81,20 @@ inline void set_admux_voltage() {
         #ifdef USE_VOLTAGE_DIVIDER  // 1.1V / ADC input pin
             // verify that this is correct!!!  untested
             ADC0.MUXPOS = ADMUX_VOLTAGE_DIVIDER;  // read the requested ADC pin
-            ADC0.CTRLC = ADC_SAMPCAP_bm | ADC_PRESC_DIV64_gc | ADC_REFSEL_INTREF_gc; // Use internal ADC reference
+            ADC0.CTRLC = ADC_SAMPCAP_bm | ADC_PRESC_NOW | ADC_REFSEL_INTREF_gc; // Use internal ADC reference
         #else  // VCC / 1.1V reference
             ADC0.MUXPOS = ADC_MUXPOS_INTREF_gc;  // read internal reference
-            ADC0.CTRLC = ADC_SAMPCAP_bm | ADC_PRESC_DIV64_gc | ADC_REFSEL_VDDREF_gc; // Vdd (Vcc) be ADC reference
+            ADC0.CTRLC = ADC_SAMPCAP_bm | ADC_PRESC_NOW | ADC_REFSEL_VDDREF_gc; // Vdd (Vcc) be ADC reference
         #endif
     #else
         #error Unrecognized MCU type
     #endif
     adc_channel = 0;
     adc_sample_count = 0;  // first result is unstable
+    #ifdef USE_ADC_OVERSAMPLING
+    adc_accum[0] = 0;
+    adc_burst_count = 0;
+    #endif
     ADC_start_measurement();
 }
 
@@ -141,6 +153,61 @@ inline void ADC_off() {
     #endif
 }
 
+#ifdef USE_ADC_SLEEP
+// measure battery voltage with the CPU halted, then turn the ADC off again
+// (quieter readings, and the ADC + reference are only on for the
+//  ~100us per conversion instead of the rest of the standby tick)
+// the result arrives via the regular ISR, which sets irq_adc
+void ADC_sleep_measure() {
+    #ifdef PRR_USED
+    PRR &= ~(1 << PRADC);  // it's gated during standby
+    #endif
+    set_admux_voltage();  // also resets the junk-sample counter
+    #ifdef AVRXMEGA3  // ATTINY816, 817, etc
+        VREF.CTRLA |= VREF_ADC0REFSEL_1V1_gc; // Set Vbg ref to 1.1V
+        // single conversions, and keep running in standby sleep
+        ADC0.CTRLA = ADC_ENABLE_bm | ADC_RUNSTBY_bm;
+        set_sleep_mode(SLEEP_MODE_STANDBY);
+    #else
+        #ifdef USE_VOLTAGE_DIVIDER
+        VOLTAGE_ADC_DIDR |= (1 << VOLTAGE_ADC);
+        #endif
+        #if (ATTINY == 1634)
+        ADCSRB |= (1 << ADLAR);
+        #endif
+        // single conversions, interrupt when done
+        ADCSRA = (1 << ADEN) | (1 << ADIE) | ADC_PRSCL;
+        set_sleep_mode(SLEEP_MODE_ADC);
+    #endif
+
+    // one junk sample, then the real one(s)
+    for (uint8_t i=0; i<=ADC_SLEEP_SAMPLES; i++) {
+        cli();
+        #ifdef AVRXMEGA3
+        ADC0.COMMAND = ADC_STCONV_bm;
+        #endif
+        // (entering ADC sleep starts a conversion on the classic MCUs)
+        sleep_enable();
+        FSM_PROBE(PROBE_SLEEP);
+        sei();  // the next instruction always runs before any interrupt
+        sleep_cpu();
+        FSM_PROBE_END(PROBE_SLEEP);
+        sleep_disable();
+        // if something else woke us, let the conversion finish
+        #ifdef AVRXMEGA3
+        while (ADC0.COMMAND & ADC_STCONV_bm) {}
+        #else
+        while (ADCSRA & (1 << ADSC)) {}
+        #endif
+    }
+
+    ADC_off();
+    #ifdef PRR_USED
+    PRR |= (1 << PRADC);
+    #endif
+}
+#endif
+
 #ifdef USE_VOLTAGE_DIVIDER
 static inline uint8_t calc_voltage_divider(uint16_t value) {
     // use 9.7 fixed-point to get sufficient precision
@@ -154,6 +221,65 @@ static inline uint8_t calc_voltage_divider(uint16_t value) {
                      ;
     return result;
 }
+#ifdef USE_ADC_OVERSAMPLING
+// same thing, but volts * 100
+static inline uint16_t calc_voltage_divider_cv(uint16_t value) {
+    uint16_t adc_per_volt = ((ADC_44<<5) - (ADC_22<<5)) / (44-22);
+    uint16_t result = (((uint32_t)value * 5) / adc_per_volt)
+                      + (VOLTAGE_FUDGE_FACTOR * 10)
+                      #ifdef USE_VOLTAGE_CORRECTION
+                      + ((voltage_correction - 7) * 10)
+                      #endif
+                      ;
+    return result;
+}
+#endif
+#endif
+
+#ifdef USE_LVP
+// convert a left-aligned ADC value to volts * 10
+// (or volts * 100, with oversampling)
+static inline vfine_t calc_voltage(uint16_t measurement) {
+    #ifdef USE_ADC_OVERSAMPLING
+    // oversampled and filtered values don't flap, so no rounding needed
+    #ifdef USE_VOLTAGE_DIVIDER
+    return calc_voltage_divider_cv(measurement);
+    #else
+    // volts * 100 = 1.1 * 65536 * 100 / ADC (left-aligned)
+    // (fudge factor and correction are in 0.05V units)
+    return ((uint32_t)(1.1*65536*100) / measurement)
+           + (VOLTAGE_FUDGE_FACTOR * 5)
+           #ifdef USE_VOLTAGE_CORRECTION
+           + ((voltage_correction - 7) * 5)
+           #endif
+           ;
+    #endif
+    #else  // no oversampling
+    // values stair-step between intervals of 64, with random variations
+    // of 1 or 2 in either direction, so if we chop off the last 6 bits
+    // it'll flap between N and N-1...  but if we add half an interval,
+    // the values should be really stable after right-alignment
+    // (instead of 99.98, 100.00, and 100.02, it'll hit values like
+    //  100.48, 100.50, and 100.52...  which are stable when truncated)
+    //measurement += 32;
+    //measurement = (measurement + 16) >> 5;
+    measurement = (measurement + 16) & 0xffe0;  // 1111 1111 1110 0000
+
+    #ifdef USE_VOLTAGE_DIVIDER
+    return calc_voltage_divider(measurement);
+    #else
+    // calculate actual voltage: volts * 10
+    // ADC = 1.1 * 1024 / volts
+    // volts = 1.1 * 1024 / ADC
+    return ((uint16_t)(2*1.1*1024*10)/(measurement>>6)
+            + VOLTAGE_FUDGE_FACTOR
+            #ifdef USE_VOLTAGE_CORRECTION
+            + voltage_correction - 7
+            #endif
+            ) >> 1;
+    #endif
+    #endif  // no oversampling
+}
 #endif
 
 // Each full cycle runs ~2X per second with just voltage enabled,
@@ -169,6 +295,7 @@ static inline uint8_t calc_voltage_divider(uint16_t value) {
 #endif
 // happens every time the ADC sampler finishes a measurement
 ISR(ADC_vect) {
+    FSM_PROBE_SCOPE(PROBE_ADC_ISR);
 
     #ifdef AVRXMEGA3  // ATTINY816, 817, etc
     ADC0.INTFLAGS = ADC_RESRDY_bm; // clear the interrupt
@@ -198,19 +325,44 @@ ISR(ADC_vect) {
         #else
         m = ADC;
         #endif
+
+        #ifdef USE_ADC_OVERSAMPLING
+        // add up a burst of samples, then decimate
+        // (10 bits + N extra bits, left-aligned like a regular sample)
+        // (but not while asleep, unless it's measuring in ADC sleep,
+        //  because otherwise the ADC only runs during the brief moments
+        //  the MCU is awake, so a burst would take ages)
+        #if defined(TICK_DURING_STANDBY) && !defined(USE_ADC_SLEEP)
+        if (! go_to_standby)
+        #endif
+        {
+            uint16_t *a = adc_accum + channel;
+            *a += m >> 6;
+            if (++adc_burst_count < ADC_OVERSAMPLE_COUNT) return;
+            adc_burst_count = 0;
+            m = *a << (6 - (2*ADC_OVERSAMPLE_BITS));
+            *a = 0;
+        }
+        #endif
         adc_raw[channel] = m;
 
         // lowpass the value
         //s = adc_smooth[channel];  // easier to read
         uint16_t *v = adc_smooth + channel;  // compiles smaller
         s = *v;
+        #ifdef USE_ADC_OVERSAMPLING
+        // IIR filter, one step per burst
+        // (low bits are unused, so shifting first doesn't lose anything)
+        s = s - (s >> ADC_IIR_SHIFT) + (m >> ADC_IIR_SHIFT);
+        #else
         if (m > s) { s++; }
         if (m < s) { s--; }
+        #endif
         //adc_smooth[channel] = s;
         *v = s;
 
         // track what woke us up, and enable deferred logic
-        irq_adc = 1;
+        irq_post(IRQ_ADC);
 
     }
 
@@ -222,8 +374,7 @@ ISR(ADC_vect) {
 }
 
 void adc_deferred() {
-    irq_adc = 0;  // event handled
-
+    FSM_PROBE_SCOPE(PROBE_ADC_DEFERRED);
     #ifdef USE_PSEUDO_RAND
     // real-world entropy makes this a true random, not pseudo
     // Why here instead of the ISR?  Because it makes the time-critical ISR
@@ -291,6 +442,19 @@ void adc_deferred() {
 }
 
 
+#ifdef USE_BATT_IR_COMPENSATION
+uint8_t batt_load(uint8_t level) {
+    #ifdef USE_ENERGY_METER
+    // use the current model when there is one
+    return ((uint32_t)batt_ma(level) * 255) / batt_ma(RAMP_SIZE);
+    #else
+    // ramps are roughly cubic, so relative current is roughly (level/max)^3
+    uint16_t l = (uint16_t)level * 255 / RAMP_SIZE;
+    return ((l * l / 255) * l) / 255;
+    #endif
+}
+#endif
+
 #ifdef USE_LVP
 static inline void ADC_voltage_handler() {
     // rate-limit low-voltage warnings to a max of 1 per N seconds
@@ -330,28 +494,85 @@ static inline void ADC_voltage_handler() {
     #endif
     else measurement = adc_smooth[0];
 
-    // values stair-step between intervals of 64, with random variations
-    // of 1 or 2 in either direction, so if we chop off the last 6 bits
-    // it'll flap between N and N-1...  but if we add half an interval,
-    // the values should be really stable after right-alignment
-    // (instead of 99.98, 100.00, and 100.02, it'll hit values like
-    //  100.48, 100.50, and 100.52...  which are stable when truncated)
-    //measurement += 32;
-    //measurement = (measurement + 16) >> 5;
-    measurement = (measurement + 16) & 0xffe0;  // 1111 1111 1110 0000
+    vfine_t v;  // voltage, or open-circuit estimate
+    vfine_t loaded;  // voltage actually measured
+
+    #ifdef USE_BATT_IR_COMPENSATION
+    {
+        // compare readings before and after each change in output level,
+        // once the load has been steady long enough for the lowpass to settle
+        static uint8_t prev_load = 0;
+        static uint8_t ref_load = 0;
+        static uint16_t ref_measurement = 0;  // 0 = no usable reference
+        uint8_t load = batt_load(actual_level);
+        if (adc_reset) ref_measurement = 0;  // raw value, not settled
+        else if (load == prev_load) {
+            int16_t diff = (int16_t)load - ref_load;
+            if (ref_measurement &&
+                ((diff >= BATT_IR_MIN_LOAD_STEP) || (diff <= -BATT_IR_MIN_LOAD_STEP))) {
+                int32_t ir = ((int32_t)(int16_t)(ref_measurement - measurement) * 255) / diff;
+                // (a glitched reference can give any value, even the wrong sign)
+                #ifdef USE_VOLTAGE_DIVIDER
+                if (ir < 0) ir = 0;
+                if (ir > BATT_IR_MAX) ir = BATT_IR_MAX;
+                #else  // VCC readings go up when the voltage goes down
+                if (ir > 0) ir = 0;
+                if (ir < -BATT_IR_MAX) ir = -BATT_IR_MAX;
+                #endif
+                batt_ir += ((int16_t)ir - batt_ir) >> 2;
+            }
+            ref_measurement = measurement;
+            ref_load = load;
+        }
+        prev_load = load;
 
-    #ifdef USE_VOLTAGE_DIVIDER
-    voltage = calc_voltage_divider(measurement);
+        loaded = calc_voltage(measurement);
+
+        // add back the estimated sag, and clamp it to a sane range
+        int32_t ocv = (int32_t)measurement + (((int32_t)batt_ir * load) / 255);
+        if (ocv < 64) ocv = 64;
+        if (ocv > 0xffc0) ocv = 0xffc0;
+        v = calc_voltage(ocv);
+        if (v < loaded) v = loaded;
+        if (v > loaded + VFINE(VOLTAGE_SAG_MAX)) v = loaded + VFINE(VOLTAGE_SAG_MAX);
+    }
+    voltage_loaded = loaded / VFINE(1);
     #else
-    // calculate actual voltage: volts * 10
-    // ADC = 1.1 * 1024 / volts
-    // volts = 1.1 * 1024 / ADC
-    voltage = ((uint16_t)(2*1.1*1024*10)/(measurement>>6)
-               + VOLTAGE_FUDGE_FACTOR
-               #ifdef USE_VOLTAGE_CORRECTION
-               + voltage_correction - 7
-               #endif
-               ) >> 1;
+    v = loaded = calc_voltage(measurement);
+    #endif
+    voltage = v / VFINE(1);
+    #ifdef USE_ADC_OVERSAMPLING
+    voltage_cv = v;
+    #endif
+
+    #ifdef USE_ENERGY_METER
+    // track the resting voltage, and check for a freshly charged battery
+    energy_voltage_update();
+    #endif
+
+    #ifdef USE_SMOOTH_LVP
+    // track the loaded voltage over the last few measurements,
+    // to predict where it'll be a few seconds from now
+    #define NUM_LVP_HISTORY_STEPS 8  // must be a power of 2
+    static vfine_t lvp_history[NUM_LVP_HISTORY_STEPS];
+    static uint8_t lvp_history_step = 0;
+    static uint8_t lvp_history_level = 0;
+    // old values are stale after waking, and after any change in output
+    // (or a jump from moon to turbo looks like a battery falling fast)
+    if (adc_reset || (actual_level != lvp_history_level)) {
+        for (uint8_t i=0; i<NUM_LVP_HISTORY_STEPS; i++)
+            lvp_history[i] = loaded;
+        lvp_history_level = actual_level;
+    }
+    // slope is negative while the voltage is falling
+    int16_t predicted = loaded + loaded - lvp_history[lvp_history_step];
+    lvp_history[lvp_history_step] = loaded;
+    lvp_history_step = (lvp_history_step + 1) & (NUM_LVP_HISTORY_STEPS-1);
+
+    // how long has it been below the hard cutoff?
+    static uint8_t lvp_cutoff_readings = 0;
+    if (loaded >= VFINE(LVP_CUTOFF_VOLTAGE)) lvp_cutoff_readings = 0;
+    else if (lvp_cutoff_readings < LVP_CUTOFF_READINGS) lvp_cutoff_readings ++;
     #endif
 
     // if low, callback EV_voltage_low / EV_voltage_critical
@@ -359,16 +580,38 @@ static inline void ADC_voltage_handler() {
     if (lvp_timer) {
         lvp_timer --;
     } else {  // it has been long enough since the last warning
+        #ifdef USE_SMOOTH_LVP
+        if (lvp_cutoff_readings >= LVP_CUTOFF_READINGS) {
+            emit(EV_voltage_low, LVP_HARD_CUTOFF);
+            count_lvp_event();
+            lvp_timer = LVP_TIMER_START;
+        }
+        else
+        #endif
     	#ifdef DUAL_VOLTAGE_FLOOR
     	if (((voltage < VOLTAGE_LOW) && (voltage > DUAL_VOLTAGE_FLOOR)) || (voltage < DUAL_VOLTAGE_LOW_LOW)) {
     	#else
-        if (voltage < VOLTAGE_LOW) {
+        if (v < VOLTAGE_LOW_FINE) {
         #endif
             // send out a warning
             emit(EV_voltage_low, 0);
+            count_lvp_event();
             // reset rate-limit counter
             lvp_timer = LVP_TIMER_START;
         }
+        #ifdef USE_SMOOTH_LVP
+        // headed below the target: ask for a reduction proportional
+        // to how far below it's going to be
+        else if (actual_level && (predicted < VFINE(LVP_TARGET_VOLTAGE))) {
+            int16_t howmuch = (VFINE(LVP_TARGET_VOLTAGE) - predicted)
+                              * LVP_RESPONSE_MAGNITUDE / VFINE(1);
+            if (howmuch < 1) howmuch = 1;
+            if (howmuch > LVP_HARD_CUTOFF-1) howmuch = LVP_HARD_CUTOFF-1;
+            emit(EV_voltage_low, howmuch);
+            // (counted by the UI, only if it actually steps down)
+            lvp_timer = LVP_ADJUST_SECONDS*ADC_CYCLES_PER_SECOND;
+        }
+        #endif
     }
 }
 #endif
@@ -486,6 +729,7 @@ static inline void ADC_temperature_handler() {
 
             // send a warning
             emit(EV_temperature_high, howmuch);
+            perf_count(thermal_events);
         }
     }
 
@@ -505,8 +749,10 @@ static inline void ADC_temperature_handler() {
             int16_t howmuch = (-BELOW) >> 1;
             // send a notification (unless voltage is low)
             // (LVP and underheat warnings fight each other)
-            if (voltage > (VOLTAGE_LOW + 1))
+            if (voltage > (VOLTAGE_LOW + 1)) {
                 emit(EV_temperature_low, howmuch);
+                perf_count(thermal_events);
+            }
         }
     }
     #undef BELOW
@@ -542,6 +788,10 @@ PROGMEM const uint8_t voltage_blinks[] = {
 void battcheck() {
     #ifdef BATTCHECK_VpT
     blink_num(voltage);
+    #ifdef USE_EXTRA_BATTCHECK_DIGIT
+    // and hundredths
+    blink_digit(voltage_cv % 10);
+    #endif
     #else
     uint8_t i;
     for(i=0;
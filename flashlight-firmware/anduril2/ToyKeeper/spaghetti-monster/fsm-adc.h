@@ -45,11 +45,27 @@ volatile uint8_t adc_reset = 2;
 #endif
 #endif
 
-volatile uint8_t irq_adc = 0;  // ADC interrupt happened?
 uint8_t adc_sample_count = 0;  // skip the first sample; it's junk
 uint8_t adc_channel = 0;  // 0=voltage, 1=temperature
 uint16_t adc_raw[2];  // last ADC measurements (0=voltage, 1=temperature)
 uint16_t adc_smooth[2];  // lowpassed ADC measurements (0=voltage, 1=temperature)
+#ifdef USE_ADC_OVERSAMPLING
+// add up bursts of 4^N samples, for N extra bits of resolution
+// (so 2 = bursts of 16, for 12-bit results)
+#ifndef ADC_OVERSAMPLE_BITS
+#define ADC_OVERSAMPLE_BITS 2
+#endif
+#if ADC_OVERSAMPLE_BITS > 3
+#error ADC_OVERSAMPLE_BITS must be 3 or less
+#endif
+#define ADC_OVERSAMPLE_COUNT (1 << (2*ADC_OVERSAMPLE_BITS))
+// lowpass each burst with a time constant of 2^N bursts
+#ifndef ADC_IIR_SHIFT
+#define ADC_IIR_SHIFT 3
+#endif
+uint16_t adc_accum[2];  // sum of the current burst
+uint8_t adc_burst_count = 0;  // samples in the current burst
+#endif
 // ADC code is split into two parts:
 // - ISR: runs immediately at each interrupt, does the bare minimum because time is critical here
 // - deferred: the bulk of the logic runs later when time isn't so critical
@@ -57,21 +73,119 @@ uint8_t adc_deferred_enable = 0;  // stop waiting and run the deferred code
 void adc_deferred();  // do the actual ADC-related calculations
 
 static inline void ADC_voltage_handler();
+// an LVP cutoff or step-down happened (for USE_PERF_COUNTERS and USE_TELEMETRY)
+#define count_lvp_event() do { \
+    perf_count(lvp_events); telemetry_count(lvp_events); \
+    } while (0)
 uint8_t voltage = 0;
+#ifdef USE_ADC_OVERSAMPLING
+// battery voltage in volts * 100
+uint16_t voltage_cv = 0;
+// internal voltage calculations use the finest available units
+typedef uint16_t vfine_t;
+#define VFINE(dv) ((dv)*10)  // convert volts * 10 to fine units
+// low-battery threshold in volts * 100, for finer control than VOLTAGE_LOW
+#ifndef VOLTAGE_LOW_CV
+#define VOLTAGE_LOW_CV (VOLTAGE_LOW*10)
+#endif
+#define VOLTAGE_LOW_FINE VOLTAGE_LOW_CV
+#define voltage_fine voltage_cv
+#else
+typedef uint8_t vfine_t;
+#define VFINE(dv) (dv)
+#define VOLTAGE_LOW_FINE VOLTAGE_LOW
+#define voltage_fine voltage
+#endif
 #ifdef USE_VOLTAGE_CORRECTION
 // same 0.05V units as fudge factor,
 // but 7 is neutral, and the expected range is from 1 to 13
 uint8_t voltage_correction = 7;
 #endif
+#ifdef USE_BATT_IR_COMPENSATION
+// estimate the cell's internal resistance from how much the voltage moves
+// when the output level changes, then use that to calculate the battery's
+// open-circuit voltage ... so a healthy cell doesn't trigger LVP (or show
+// a low battcheck / aux color) just because of voltage sag at high power
+// "voltage" holds the estimated open-circuit value in this case,
+// and "voltage_loaded" holds the value actually measured
+#ifndef USE_RAMPING
+#error USE_BATT_IR_COMPENSATION requires USE_RAMPING
+#endif
+// max amount of sag to compensate for, in volts * 10
+// (so LVP still happens when the loaded voltage drops below
+//  VOLTAGE_LOW - VOLTAGE_SAG_MAX, no matter what the estimate says)
+#ifndef VOLTAGE_SAG_MAX
+#define VOLTAGE_SAG_MAX 4
+#endif
+// ignore level changes smaller than this (on a 0 to 255 load scale)
+#ifndef BATT_IR_MIN_LOAD_STEP
+#define BATT_IR_MIN_LOAD_STEP 32
+#endif
+// largest believable internal resistance, in batt_ir units
+// (1/8 of the ADC's range ... a glitched reading can look like much more)
+#ifndef BATT_IR_MAX
+#define BATT_IR_MAX 0x2000
+#endif
+uint8_t voltage_loaded = 0;
+// internal resistance, in raw ADC units of sag at full load
+// (positive with a voltage divider, negative with VCC readings,
+//  because VCC readings go up when the voltage goes down)
+int16_t batt_ir = 0;
+// approximate relative battery current at a ramp level, 0 to 255
+uint8_t batt_load(uint8_t level);
+#endif
+#ifdef USE_SMOOTH_LVP
+// predictive LVP: watch where the loaded voltage is heading, and send
+// EV_voltage_low with arg = number of levels to drop, before it gets
+// below the target ... so states which can adjust gradually can hold
+// the voltage just above the cutoff instead of stepping down in big jumps
+// arg 0 still means "battery is empty" like regular LVP,
+// and LVP_HARD_CUTOFF means "turn off now"
+// (states which don't handle it just ignore the early warnings)
+#ifndef USE_RAMPING
+#error USE_SMOOTH_LVP requires USE_RAMPING
+#endif
+#define LVP_HARD_CUTOFF 255
+// try to keep the loaded voltage at or above this, in volts * 10
+#ifndef LVP_TARGET_VOLTAGE
+#define LVP_TARGET_VOLTAGE (VOLTAGE_LOW+1)
+#endif
+// always shut off if the loaded voltage drops below this
+#ifndef LVP_CUTOFF_VOLTAGE
+#define LVP_CUTOFF_VOLTAGE (VOLTAGE_LOW-4)
+#endif
+// ... for this many measurements in a row
+// (the first sample after a jump to turbo can sag that far on a cell
+//  which is fine, and regular LVP steps down in the meantime)
+#ifndef LVP_CUTOFF_READINGS
+#define LVP_CUTOFF_READINGS 3
+#endif
+// how many levels to drop per 0.1V below the target
+// (Anduril with the energy meter: how many 16ths of the current)
+#ifndef LVP_RESPONSE_MAGNITUDE
+#define LVP_RESPONSE_MAGNITUDE 4
+#endif
+// seconds between adjustments
+#ifndef LVP_ADJUST_SECONDS
+#define LVP_ADJUST_SECONDS 2
+#endif
+#endif
 #ifdef USE_LVP
 void low_voltage();
 #endif
+#ifdef USE_SMOOTH_LVP
+// the UI must turn off here, in any state
+void lvp_hard_cutoff();
+#endif
 
 #ifdef USE_BATTCHECK
 void battcheck();
 #ifdef BATTCHECK_VpT
 #define USE_BLINK_NUM
 #endif
+#if defined(USE_EXTRA_BATTCHECK_DIGIT) && !defined(USE_ADC_OVERSAMPLING)
+#undef USE_EXTRA_BATTCHECK_DIGIT  // not enough resolution for it
+#endif
 #if defined(BATTCHECK_8bars) || defined(BATTCHECK_6bars) || defined(BATTCHECK_4bars)
 #define USE_BLINK_DIGIT
 #endif
@@ -104,5 +218,26 @@ inline void ADC_on();
 inline void ADC_off();
 inline void ADC_start_measurement();
 
+#ifdef AVRXMEGA3  // ATTINY816, 817, etc
+// ADC clock is CLK_PER / 64, about 78 kHz at 5 MHz ...
+// so when the CPU is underclocked, divide by less to stay above 50 kHz
+#ifdef USE_DYNAMIC_UNDERCLOCKING
+#define ADC_PRESC_NOW (ADC_PRESC_DIV64_gc - (clock_speed_shift << ADC_PRESC_gp))
+#else
+#define ADC_PRESC_NOW ADC_PRESC_DIV64_gc
+#endif
+#endif
+
+#ifdef USE_ADC_SLEEP
+// take sleep LVP measurements with the CPU halted in ADC sleep mode
+// (gets turned off in fsm-wdt.h if there's no sleep LVP)
+#ifdef USE_ADC_OVERSAMPLING
+#define ADC_SLEEP_SAMPLES ADC_OVERSAMPLE_COUNT
+#else
+#define ADC_SLEEP_SAMPLES 1
+#endif
+void ADC_sleep_measure();
+#endif
+
 
 #endif
@@ -0,0 +1,72 @@
+/*
+ * fsm-clock.c: Seconds counter for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_CLOCK_C
+#define FSM_CLOCK_C
+
+#ifdef USE_SECONDS_CLOCK
+
+void clock_setup() {
+    #ifdef AVRXMEGA3
+    // free-running RTC counter, from the same oscillator as the PIT
+    while (RTC.STATUS > 0) {}  // make sure the registers are ready
+    RTC.PER = 0xffff;
+    RTC.CTRLA = RTC_PRESCALER_DIV1_gc | RTC_RTCEN_bm;
+    #endif
+}
+
+static void clock_add(uint32_t units) {
+    units += clock_units;
+    while (units >= CLOCK_UNITS_PER_SECOND) {
+        units -= CLOCK_UNITS_PER_SECOND;
+        clock_seconds ++;
+    }
+    clock_units = units;
+}
+
+void clock_update() {
+    uint8_t sreg = SREG;
+    cli();
+    uint16_t ticks = clock_pending_ticks;
+    clock_pending_ticks = 0;
+    SREG = sreg;
+
+    #ifdef AVRXMEGA3
+    uint16_t now = RTC.CNT;
+    #ifdef TICK_DURING_STANDBY
+    if (go_to_standby) {
+        // the counter may not have run, so count the PIT ticks
+        clock_add((uint32_t)ticks * CLOCK_UNITS_PER_TICK);
+    }
+    else
+    #endif
+    {
+        // exact, even if interrupts were off for longer than a tick
+        // (wraps every 2s, and this runs at least every 16ms while awake)
+        clock_add((uint16_t)(now - clock_rtc_last));
+    }
+    clock_rtc_last = now;
+    #else
+    // (ticks lost while interrupts were off can't be counted here,
+    //  but merged ones can)
+    clock_add((uint32_t)ticks * CLOCK_UNITS_PER_TICK);
+    #endif
+}
+
+#endif  // ifdef USE_SECONDS_CLOCK
+
+#endif
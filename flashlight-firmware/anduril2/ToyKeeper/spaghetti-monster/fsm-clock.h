@@ -0,0 +1,66 @@
+/*
+ * fsm-clock.h: Seconds counter for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_CLOCK_H
+#define FSM_CLOCK_H
+
+#ifdef USE_SECONDS_CLOCK
+
+// seconds since power was connected, awake or asleep
+// (keeps counting through standby only with TICK_DURING_STANDBY)
+// counts real time, so it doesn't care how long each tick is...
+// wraps after 136 years, so compare by subtracting: (clock_seconds - then)
+uint32_t clock_seconds = 0;
+
+#ifdef AVRXMEGA3  // ATTINY816, 817, etc
+// the PIT ticks every 512 cycles of the 32 kHz RTC oscillator (64 Hz),
+// and while awake the RTC counter gives the time directly, in cycles
+// (it stops in power-down sleep, so standby still counts PIT ticks)
+#define CLOCK_UNITS_PER_SECOND 32768UL
+#define CLOCK_UNITS_PER_TICK 512
+uint16_t clock_rtc_last = 0;
+#else
+// the WDT runs at 62.5 Hz, so count half-ticks
+#define CLOCK_UNITS_PER_SECOND 125
+#define CLOCK_UNITS_PER_TICK 2
+#endif
+// time left over from the last whole second, in the units above
+uint16_t clock_units = 0;
+
+// awake-speed ticks per WDT interrupt, at the speed it's set to now
+// (WDT_on() and WDT_slow() keep this up to date)
+uint16_t clock_wdt_ticks = 1;
+// ticks the WDT ISR has seen which haven't been counted yet
+// (so ticks which arrive before the last one was handled still count,
+//  even though they only run WDT_inner() once)
+volatile uint16_t clock_pending_ticks = 0;
+#define clock_isr() (clock_pending_ticks += clock_wdt_ticks)
+
+// called once at boot
+void clock_setup();
+// called from WDT_inner(), counts the time since the last call
+void clock_update();
+
+#ifdef TICK_DURING_STANDBY
+// when the current (or last) standby period began
+uint32_t standby_start_seconds = 0;
+#define standby_seconds() (clock_seconds - standby_start_seconds)
+#endif
+
+#endif  // ifdef USE_SECONDS_CLOCK
+
+#endif
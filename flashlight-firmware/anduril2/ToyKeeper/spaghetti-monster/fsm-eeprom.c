@@ -22,6 +22,25 @@
 
 #include "fsm-eeprom.h"
 
+#if defined(USE_FAST_BOOT) && (defined(LED_ENABLE_PIN) || defined(LED2_ENABLE_PIN))
+// The power-settle delay is only for the load of the LED power switching
+// on or off.  USE_FAST_BOOT skips it when that power is off, like at boot.
+// That isn't assumed here, it's checked on the pins, so the skip is safe
+// on every MCU and hwdef.  (In practice the enable pins reset low on every
+// MCU, the attiny85/1634 PORTx and the 1-series PORTx.OUT alike, and no
+// hwdef_setup() raises them.)
+#ifdef LED2_ENABLE_PIN
+#define LED2_POWER_ENABLED (LED2_ENABLE_PORT & (1 << LED2_ENABLE_PIN))
+#else
+#define LED2_POWER_ENABLED 0
+#endif
+#ifdef LED_ENABLE_PIN
+#define LED_POWER_ENABLED ((LED_ENABLE_PORT & (1 << LED_ENABLE_PIN)) || LED2_POWER_ENABLED)
+#else
+#define LED_POWER_ENABLED LED2_POWER_ENABLED
+#endif
+#endif
+
 #ifdef USE_EEPROM
 #ifdef EEPROM_OVERRIDE
 uint8_t *eeprom;
@@ -31,6 +50,9 @@ uint8_t eeprom[EEPROM_BYTES];
 
 uint8_t load_eeprom() {
     #if defined(LED_ENABLE_PIN) || defined(LED2_ENABLE_PIN)
+    #ifdef USE_FAST_BOOT
+    if (LED_POWER_ENABLED)
+    #endif
     delay_4ms(2);  // wait for power to stabilize
     #endif
 
@@ -40,9 +62,14 @@ uint8_t load_eeprom() {
     if (marker != EEP_MARKER) { sei(); return 0; }
 
     // load the actual data
+    #ifdef USE_FAST_BOOT
+    // one sequential read, instead of setting up the address each byte
+    eeprom_read_block(eeprom, (const void *)(EEP_START+1), EEPROM_BYTES);
+    #else
     for(uint8_t i=0; i<EEPROM_BYTES; i++) {
         eeprom[i] = eeprom_read_byte((uint8_t *)(EEP_START+1+i));
     }
+    #endif
     sei();
     return 1;
 }
@@ -61,6 +88,10 @@ void save_eeprom() {
 
     // save the marker last, to indicate the transaction is complete
     eeprom_update_byte((uint8_t *)EEP_START, EEP_MARKER);
+    #ifdef USE_PERF_COUNTERS
+    // did a clock tick have to wait for this?
+    if (WDT_irq_waiting()) perf_count(late_ticks);
+    #endif
     sei();
 }
 #endif
@@ -71,6 +102,9 @@ uint8_t * eep_wl_prev_offset;
 
 uint8_t load_eeprom_wl() {
     #if defined(LED_ENABLE_PIN) || defined(LED2_ENABLE_PIN)
+    #ifdef USE_FAST_BOOT
+    if (LED_POWER_ENABLED)
+    #endif
     delay_4ms(2);  // wait for power to stabilize
     #endif
 
@@ -90,9 +124,13 @@ uint8_t load_eeprom_wl() {
 
     if (found) {
         // load the actual data
+        #ifdef USE_FAST_BOOT
+        eeprom_read_block(eeprom_wl, offset+1, EEPROM_WL_BYTES);
+        #else
         for(uint8_t i=0; i<EEPROM_WL_BYTES; i++) {
             eeprom_wl[i] = eeprom_read_byte(offset+1+i);
         }
+        #endif
     }
     sei();
     return found;
@@ -122,6 +160,9 @@ void save_eeprom_wl() {
     for(uint8_t i=0; i<EEPROM_WL_BYTES; i++, offset++) {
         eeprom_update_byte(offset, eeprom_wl[i]);
     }
+    #ifdef USE_PERF_COUNTERS
+    if (WDT_irq_waiting()) perf_count(late_ticks);
+    #endif
     sei();
 }
 #endif
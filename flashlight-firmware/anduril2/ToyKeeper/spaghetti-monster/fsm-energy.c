@@ -0,0 +1,140 @@
+/*
+ * fsm-energy.c: Battery energy accounting for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_ENERGY_C
+#define FSM_ENERGY_C
+
+#ifdef USE_ENERGY_METER
+
+// charge used since the last whole mAh, in uA * ticks
+uint32_t energy_ua_ticks = 0;
+// energy used since the last whole mWh, in 0.1 mWh units
+uint8_t energy_mwh_tenths = 0;
+
+uint16_t batt_ma(uint8_t level) {
+    if (! level) return 0;
+    return pgm_read_word(batt_ma_levels + level - 1);
+}
+
+static void energy_add(uint32_t ua_ticks) {
+    energy_ua_ticks += ua_ticks;
+    if (energy_ua_ticks >= ENERGY_UA_TICKS_PER_MAH) {
+        energy_ua_ticks -= ENERGY_UA_TICKS_PER_MAH;
+        energy_mah ++;
+        // 1 mAh at N volts * 10 is N * 0.1 mWh
+        // (use the measured voltage, not the open-circuit estimate,
+        //  because that's what the driver actually gets)
+        #ifdef USE_BATT_IR_COMPENSATION
+        energy_mwh_tenths += voltage_loaded;
+        #else
+        energy_mwh_tenths += voltage;
+        #endif
+        while (energy_mwh_tenths >= 10) {
+            energy_mwh_tenths -= 10;
+            energy_mwh ++;
+        }
+    }
+}
+
+void energy_tick() {
+    energy_add((uint32_t)batt_ma(actual_level) * 1000);
+}
+
+#ifdef TICK_DURING_STANDBY
+void energy_sleep_tick() {
+    // each sleep tick lasts 2^STANDBY_TICK_SPEED awake ticks
+    #ifdef USE_ADAPTIVE_STANDBY
+    energy_add(((uint32_t)BATT_STANDBY_UA << STANDBY_TICK_SPEED) * standby_tick_step);
+    #else
+    energy_add((uint32_t)BATT_STANDBY_UA << STANDBY_TICK_SPEED);
+    #endif
+}
+#endif
+
+// resting li-ion cell voltage vs remaining charge, from 3.0V to 4.2V
+// (0 = empty, 255 = full)
+PROGMEM const uint8_t batt_charge_curve[] = {
+    0, 5, 10, 18, 31, 51, 87, 128, 163, 191, 217, 240, 255,
+};
+uint8_t batt_charge() {
+    // "voltage" is the open-circuit estimate when that's available
+    int8_t i = voltage - 30;
+    if (i < 0) return 0;
+    if (i >= (int8_t)sizeof(batt_charge_curve)) return 255;
+    return pgm_read_byte(batt_charge_curve + i);
+}
+
+static uint16_t charge_mah() {
+    return ((uint32_t)BATT_CAPACITY_MAH * batt_charge()) / 255;
+}
+
+// check for a freshly charged battery
+static void energy_voltage_check() {
+    if ((voltage >= energy_voltage + ENERGY_RESET_VOLTAGE_RISE)
+            || (! energy_start_mah)) {
+        energy_mah = 0;
+        energy_mwh = 0;
+        energy_ua_ticks = 0;
+        energy_mwh_tenths = 0;
+        energy_start_mah = charge_mah();
+        if (! energy_start_mah) energy_start_mah = 1;
+    }
+    energy_voltage = voltage;
+}
+
+void energy_voltage_update() {
+    // only trust the voltage after the light has been off for a while
+    // (not at boot, which may go straight to a memorized level, and not
+    //  right after turning off, while the cell is still recovering)
+    #define ENERGY_REST_READINGS (ENERGY_REST_SECONDS*ADC_CYCLES_PER_SECOND)
+    static uint8_t rest = 0;
+    if (actual_level) rest = 0;
+    // (sleep LVP only measures after several seconds asleep)
+    else if (go_to_standby) rest = ENERGY_REST_READINGS;
+    else if (rest < ENERGY_REST_READINGS) rest ++;
+    if (rest < ENERGY_REST_READINGS) return;
+
+    // the first resting voltage since boot
+    if (! energy_rest_voltage) energy_voltage_check();
+    energy_rest_voltage = voltage;
+}
+
+uint16_t remaining_mah() {
+    // the voltage curve is flat in the middle, so count down from the
+    // charge at the last reset instead ... except near empty, where the
+    // voltage is steep enough to trust, and where running out early
+    // because of an optimistic count would matter most
+    uint16_t mah = 0;
+    if (energy_mah < energy_start_mah) mah = energy_start_mah - energy_mah;
+    if (batt_charge() < 32) {
+        uint16_t by_voltage = charge_mah();
+        if (by_voltage < mah) mah = by_voltage;
+    }
+    return mah;
+}
+
+uint16_t runtime_minutes(uint8_t level) {
+    uint16_t ma = batt_ma(level);
+    if (! ma) ma = 1;
+    uint32_t minutes = ((uint32_t)remaining_mah() * 60) / ma;
+    if (minutes > 0xffff) minutes = 0xffff;
+    return minutes;
+}
+
+#endif  // ifdef USE_ENERGY_METER
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * fsm-energy.h: Battery energy accounting for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_ENERGY_H
+#define FSM_ENERGY_H
+
+#ifdef USE_ENERGY_METER
+
+#if !defined(USE_RAMPING) || !defined(USE_LVP)
+#error USE_ENERGY_METER requires USE_RAMPING and USE_LVP
+#endif
+// battery current per ramp level, in mA
+// (generate this with bin/current_calc.py)
+#ifndef BATT_MA_LEVELS
+#error USE_ENERGY_METER requires BATT_MA_LEVELS
+#endif
+PROGMEM const uint16_t batt_ma_levels[] = { BATT_MA_LEVELS };
+// (indexed by ramp level, so a table for some other ramp would read past it)
+_Static_assert(sizeof(batt_ma_levels)/sizeof(batt_ma_levels[0]) == RAMP_SIZE,
+               "BATT_MA_LEVELS must have RAMP_SIZE entries");
+
+// usable capacity of a full cell, for runtime estimates
+#ifndef BATT_CAPACITY_MAH
+#define BATT_CAPACITY_MAH 3000
+#endif
+// approximate drain while asleep (MCU + voltage divider, not aux LEDs)
+#ifndef BATT_STANDBY_UA
+#define BATT_STANDBY_UA 30
+#endif
+// if the battery is this much higher (volts * 10) than at the last
+// checkpoint, it has been charged or swapped, so reset the counters
+#ifndef ENERGY_RESET_VOLTAGE_RISE
+#define ENERGY_RESET_VOLTAGE_RISE 3
+#endif
+// the light has to be off this long before the voltage counts as resting
+// (a cell sags under load, and takes a few seconds to recover after)
+#ifndef ENERGY_REST_SECONDS
+#define ENERGY_REST_SECONDS 4
+#endif
+// save the counters when turning off, but only after this many more mAh
+#ifndef ENERGY_CHECKPOINT_MAH
+#define ENERGY_CHECKPOINT_MAH 5
+#endif
+
+// WDT ticks are really 16ms, 62.5 per second
+#define ENERGY_UA_TICKS_PER_MAH (1000UL * 3600UL * 625UL / 10UL)
+
+// charge and energy used since the battery was last charged
+uint16_t energy_mah = 0;
+uint16_t energy_mwh = 0;
+// estimated charge in the battery when the counters were reset
+// (0 = unknown)
+uint16_t energy_start_mah = 0;
+// battery voltage at the last checkpoint, in volts * 10
+// (the UI should save and load all four of these)
+uint8_t energy_voltage = 0;
+// latest resting battery voltage, in volts * 10 (0 = none since boot)
+uint8_t energy_rest_voltage = 0;
+
+uint16_t batt_ma(uint8_t level);
+// remaining charge, counted down from energy_start_mah
+uint16_t remaining_mah();
+// remaining runtime at a ramp level, in minutes
+uint16_t runtime_minutes(uint8_t level);
+// how full the battery is, 0 to 255
+uint8_t batt_charge();
+// call once per awake tick
+void energy_tick();
+#ifdef TICK_DURING_STANDBY
+// call once per sleep tick
+void energy_sleep_tick();
+#endif
+// called by the voltage handler after each measurement
+void energy_voltage_update();
+// copy current state into energy_voltage before saving a checkpoint
+// (the latest resting voltage, since the light may have just turned off)
+#define energy_checkpoint() do { \
+    if (energy_rest_voltage) energy_voltage = energy_rest_voltage; \
+    } while (0)
+
+#ifdef USE_BATTCHECK
+#define USE_BLINK_BIG_NUM
+#ifndef USE_BLINK_DIGIT
+#define USE_BLINK_DIGIT
+#endif
+#endif
+
+#endif  // ifdef USE_ENERGY_METER
+
+#endif
@@ -33,8 +33,10 @@ void append_emission(Event event, uint16_t arg) {
     if (i < EMISSION_QUEUE_LEN) {
         emissions[i].event = event;
         emissions[i].arg = arg;
+        perf_max(queue_max, i + 1);
     } else {
         // TODO: if queue full, what should we do?
+        perf_count(dropped);
     }
 }
 
@@ -49,14 +51,17 @@ void delete_first_emission() {
 }
 
 void process_emissions() {
+    FSM_PROBE(PROBE_EMISSIONS);
     while (emissions[0].event != EV_none) {
         emit_now(emissions[0].event, emissions[0].arg);
         delete_first_emission();
     }
+    FSM_PROBE_END(PROBE_EMISSIONS);
 }
 
 // Call stacked callbacks for the given event until one handles it.
 uint8_t emit_now(Event event, uint16_t arg) {
+    FSM_TRACE_EVENT(event, arg);
     for(int8_t i=state_stack_len-1; i>=0; i--) {
         uint8_t err = state_stack[i](event, arg);
         if (! err) return 0;
@@ -94,6 +99,9 @@ uint8_t push_event(uint8_t ev_type) {  // only for use by PCINT_inner()
 
     // handle button presses
     if (ev_type == B_PRESS) {
+        // a hold's release ends the sequence, but the WDT only clears it
+        // on the next tick ... a press before then starts a new one
+        if (current_event & B_TIMEOUT) current_event = B_CLICK;
         // set press flag
         current_event |= B_PRESS;
         // increase click counter
@@ -140,28 +148,16 @@ uint8_t nice_delay_ms(uint16_t ms) {
 
         #ifdef USE_DYNAMIC_UNDERCLOCKING
         #ifdef USE_RAMPING
-        uint8_t level = actual_level;  // volatile, avoid repeat access
-        if (level < QUARTERSPEED_LEVEL) {
-            clock_prescale_set(clock_div_4);
-            _delay_loop_2(BOGOMIPS*90/100/4);
-        }
-        //else if (level < HALFSPEED_LEVEL) {
-        //    clock_prescale_set(clock_div_2);
-        //    _delay_loop_2(BOGOMIPS*95/100/2);
-        //}
-        else {
-            clock_prescale_set(clock_div_1);
-            _delay_loop_2(BOGOMIPS*90/100);
-        }
-        // restore regular clock speed
-        clock_prescale_set(clock_div_1);
+        // wait at whatever speed auto_clock_speed() picked for this level
+        // (changing speed here would change the PWM frequency mid-delay)
+        _delay_loop_2((BOGOMIPS*90/100) >> clock_speed_shift);
         #else
         // underclock MCU to save power
         clock_prescale_set(clock_div_4);
         // wait
         _delay_loop_2(BOGOMIPS*90/100/4);
-        // restore regular clock speed
-        clock_prescale_set(clock_div_1);
+        // restore previous clock speed
+        clock_speed_set(clock_speed_shift);
         #endif  // ifdef USE_RAMPING
         #else
         // wait
@@ -188,8 +184,9 @@ void delay_4ms(uint8_t ms) {
         clock_prescale_set(clock_div_4);
         // wait
         _delay_loop_2(BOGOMIPS*98/100);
-        // restore regular clock speed
-        clock_prescale_set(clock_div_1);
+        // restore previous clock speed
+        // (not full speed, or low modes would stay at full speed afterward)
+        clock_speed_set(clock_speed_shift);
     }
 }
 #else
@@ -28,14 +28,18 @@
 #endif
 // 4th PWM channel requires manually turning the pin on/off via interrupt :(
 ISR(TIMER1_OVF_vect) {
+    FSM_PROBE(PROBE_TIMER_ISR);
     //bitClear(PORTB, 3);
     PORTB &= 0b11110111;
     //PORTB |= 0b00001000;
+    FSM_PROBE_END(PROBE_TIMER_ISR);
 }
 ISR(TIMER1_COMPA_vect) {
+    FSM_PROBE(PROBE_TIMER_ISR);
     //if (!bitRead(TIFR,TOV1)) bitSet(PORTB, 3);
     if (! (TIFR & (1<<TOV1))) PORTB |= 0b00001000;
     //if (! (TIFR & (1<<TOV1))) PORTB &= 0b11110111;
+    FSM_PROBE_END(PROBE_TIMER_ISR);
 }
 #endif
 
@@ -84,12 +88,27 @@ static inline void hw_setup() {
     // configure e-switch
     PORTB = (1 << SWITCH_PIN);  // e-switch is the only input
     PCMSK = (1 << SWITCH_PIN);  // pin change interrupt uses this pin
+
+    #ifdef PRR_USED
+    PRR = PRR_AWAKE;  // stop unused peripherals
+    ACSR = (1 << ACD);  // FSM never uses the analog comparator
+    #endif
 }
 #elif (ATTINY == 1634) || defined(AVRXMEGA3)  // ATTINY816, 817, etc
 static inline void hw_setup() {
     // this gets tricky with so many pins...
     // ... so punt it to the hwdef file
     hwdef_setup();
+
+    #ifdef AVRXMEGA3  // ATTINY816, 817, etc
+    // BOD mode while asleep (only applies in sleep, so set it once here)
+    _PROTECTED_WRITE(BOD.CTRLA, (BOD.CTRLA & ~BOD_SLEEP_gm) | BOD_SLEEP);
+    #endif
+
+    #ifdef PRR_USED
+    PRR = PRR_AWAKE;  // stop unused peripherals
+    ACSRA = (1 << ACD);  // FSM never uses the analog comparator
+    #endif
 }
 #else
     #error Unrecognized MCU type
@@ -120,6 +139,10 @@ int main() {
     //#endif
 
     hw_setup();
+    probe_setup();  // (only in debug builds with a probe pin)
+    #ifdef USE_SECONDS_CLOCK
+    clock_setup();
+    #endif
 
     #if 0
     #ifdef HALFSPEED
@@ -137,15 +160,19 @@ int main() {
     // all booted -- turn interrupts back on
     PCINT_on();
     WDT_on();
+    #ifndef USE_FAST_BOOT
     ADC_on();
+    #endif
     sei();
 
+    #ifndef USE_FAST_BOOT
     // in case any spurious button presses were detected at boot
     #ifdef USE_DELAY_MS
     delay_ms(1);
     #else
     delay_4ms(1);
     #endif
+    #endif
 
     // fallback for handling a few things
     #ifndef DONT_USE_DEFAULT_STATE
@@ -153,9 +180,33 @@ int main() {
     nice_delay_interrupt = 0;
     #endif
 
+    #ifdef USE_FAST_BOOT
+    // setup() may check the button, so let the switch pin's pull-up
+    // settle first ... that's normally a few us, so stop as soon as it
+    // reads "not pressed", and only wait the full 4ms if it's held
+    for (uint8_t i = 0; (i < 40) && button_is_pressed(); i++)
+        _delay_loop_2(BOGOMIPS/10);  // 0.1ms
+    #endif
+
     // call recipe's setup
     setup();
 
+    #ifdef USE_FAST_BOOT
+    // get the light on first, then start the things which can wait
+    // (the first voltage reading takes a few ticks anyway, and button
+    //  events are queued until the main loop runs, so nothing is lost)
+    ADC_on();
+    #ifdef USE_DELAY_MS
+    delay_ms(1);
+    #else
+    delay_4ms(1);
+    #endif
+    #endif
+
+    #ifdef USE_TELEMETRY
+    telemetry_load();
+    #endif
+
     // main loop
     while (1) {
         // if event queue not empty, empty it
@@ -204,21 +255,33 @@ int main() {
 }
 
 
-void handle_deferred_interrupts() {
-    /*
-    if (irq_pcint) {  // button pressed or released
-        // nothing to do here
-        // (PCINT only matters during standby)
-    }
-    */
-    if (irq_adc) {  // ADC done measuring
-        adc_deferred();
-        // irq_adc = 0;  // takes care of itself
+uint8_t handle_deferred_interrupts() {
+    uint8_t handled = 0;
+    // (each bit is cleared before its handler runs,
+    //  so anything which fires during the handler isn't lost)
+    if (irq_pending(IRQ_PCINT)) {  // button pressed or released
+        irq_done(IRQ_PCINT);
+        // (it only means "wake up" ... the WDT reads the button itself,
+        //  so a press while awake after boot needs nothing else here)
+        go_to_standby = 0;
+        handled |= (1 << IRQ_PCINT);
     }
-    if (irq_wdt) {  // the clock ticked
+    if (irq_pending(IRQ_WDT)) {  // the clock ticked
+        irq_done(IRQ_WDT);
         WDT_inner();
-        // irq_wdt = 0;  // takes care of itself
+        #ifdef USE_PERF_COUNTERS
+        // did the next tick come in while this one was being handled?
+        if (irq_pending(IRQ_WDT)) perf_count(late_ticks);
+        #endif
+        handled |= (1 << IRQ_WDT);
+    }
+    // (checked again after WDT_inner(), which may have measured something)
+    if (irq_pending(IRQ_ADC)) {  // ADC done measuring
+        irq_done(IRQ_ADC);
+        adc_deferred();
+        handled |= (1 << IRQ_ADC);
     }
+    return handled;
 }
 
 #endif
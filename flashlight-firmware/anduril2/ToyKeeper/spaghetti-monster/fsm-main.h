@@ -21,7 +21,76 @@
 #define FSM_MAIN_H
 
 int main();
+
+// work posted by interrupts, for the main loop to handle later
+// (one bit per source, handled in this order, highest priority first)
+// worst-case latency, from the interrupt to its handler:
+// - PCINT: enabled from boot until the first wake-up from standby, then
+//   only in standby ... handled as soon as the MCU wakes up, or while
+//   awake after boot, in the next pass of the main loop (same as WDT)
+// - WDT: one pass of the main loop, or 1 ms inside nice_delay_ms()
+//   (longer during blocking delay_4ms() / delay_zero() calls;
+//    ticks which arrive before the last one is handled are merged)
+// - ADC: same as WDT, and handled after WDT in the same pass
+//   (so a measurement started during a sleep tick is handled right away)
+#define IRQ_PCINT 0  // button pressed or released
+#define IRQ_WDT   1  // the clock ticked
+#define IRQ_ADC   2  // ADC done measuring
+#define IRQ_SOURCES 3
+#if defined(GPIOR0) || defined(GPIO_GPIOR0)
+// keep the bits in a low I/O register, where setting or clearing one bit
+// is a single sbi / cbi instruction, so it's atomic even with interrupts on
+#ifdef GPIOR0
+#define irq_pending_bits GPIOR0
+#else
+#define irq_pending_bits GPIO_GPIOR0
+#endif
+#define irq_done(n) (irq_pending_bits &= ~(1 << (n)))
+#else
+volatile uint8_t irq_pending_bits = 0;
+#define irq_done(n) do { \
+    uint8_t sreg = SREG; cli(); \
+    irq_pending_bits &= ~(1 << (n)); \
+    SREG = sreg; \
+    } while (0)
+#endif
+#define irq_pending(n) (irq_pending_bits & (1 << (n)))
+#ifdef USE_PERF_COUNTERS
+// (also counts how many times each source fired, in perf.irqs[])
+#define irq_post(n) do { \
+    irq_pending_bits |= (1 << (n)); perf_count(irqs[n]); \
+    } while (0)
+#else
+#define irq_post(n) (irq_pending_bits |= (1 << (n)))
+#endif
+// call from ISRs only:  irq_post(n)
+// call from main code:  irq_done(n) when the work is taken
+
 // needs to run frequently to execute the logic for WDT and ADC and stuff
-void handle_deferred_interrupts();
+// (every wait point calls this, so work is always handled the same way)
+// returns which sources it handled
+uint8_t handle_deferred_interrupts();
+
+// power reduction: if the hwdef declares which peripherals it uses
+// (as PRR bits in PRR_USED), stop the clock to everything else,
+// and to everything at all while in standby
+// (the 1-series leaves peripherals off until they're enabled, so it only
+//  needs its unused pins' input buffers turned off, in hwdef_setup())
+#ifdef PRR_USED
+#if (ATTINY == 25) || (ATTINY == 45) || (ATTINY == 85)
+#define PRR_ALL ((1<<PRTIM1) | (1<<PRTIM0) | (1<<PRUSI) | (1<<PRADC))
+#elif (ATTINY == 1634)
+#define PRR_ALL ((1<<PRTWI) | (1<<PRTIM1) | (1<<PRTIM0) | (1<<PRUSI) \
+               | (1<<PRUSART1) | (1<<PRUSART0) | (1<<PRADC))
+#else
+#error PRR_USED not supported on this MCU
+#endif
+#define PRR_AWAKE (PRR_ALL & ~(PRR_USED))
+#ifdef USE_ADC_SLEEP
+#define PRR_STANDBY PRR_ALL  // ADC_sleep_measure() un-gates the ADC itself
+#else
+#define PRR_STANDBY (PRR_ALL & ~(1<<PRADC))  // sleep LVP uses the ADC
+#endif
+#endif
 
 #endif
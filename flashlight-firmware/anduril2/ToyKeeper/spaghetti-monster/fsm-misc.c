@@ -22,20 +22,35 @@
 
 
 #ifdef USE_DYNAMIC_UNDERCLOCKING
+void clock_speed_set(uint8_t shift) {
+    // (set this first, ADC_PRESC_NOW below reads it)
+    clock_speed_shift = shift;
+    // the prescaler only accepts a new value within 4 cycles after it's
+    // unlocked (CLKPCE, or the CCP signature on 1634 and 1-series), but
+    // clock_prescale_set() does the unlock and write itself, in asm,
+    // with interrupts off...  so only the one call needs to happen here
+    if (shift == 2) clock_prescale_set(clock_div_4);
+    else if (shift == 1) clock_prescale_set(clock_div_2);
+    else clock_prescale_set(clock_div_1);
+    #ifdef AVRXMEGA3  // ATTINY816, 817, etc
+    // keep the ADC clock in range (also reapplied at each channel change)
+    // (not timed, so this can safely come after the prescaler change)
+    ADC0.CTRLC = (ADC0.CTRLC & ~ADC_PRESC_gm) | ADC_PRESC_NOW;
+    #endif
+}
+
 void auto_clock_speed() {
     uint8_t level = actual_level;  // volatile, avoid repeat access
     if (level < QUARTERSPEED_LEVEL) {
         // run at quarter speed
-        // note: this only works when executed as two consecutive instructions
-        // (don't try to combine them or put other stuff between)
-        clock_prescale_set(clock_div_4);
+        clock_speed_set(2);
     }
     else if (level < HALFSPEED_LEVEL) {
         // run at half speed
-        clock_prescale_set(clock_div_2);
+        clock_speed_set(1);
     } else {
         // run at full speed
-        clock_prescale_set(clock_div_1);
+        clock_speed_set(0);
     }
 }
 #endif
@@ -21,6 +21,10 @@
 #define FSM_MISC_H
 
 #ifdef USE_DYNAMIC_UNDERCLOCKING
+// current CPU speed, as a right shift from full speed (0, 1, or 2),
+// so busy-wait delays and clock-based peripherals can compensate
+uint8_t clock_speed_shift = 0;
+void clock_speed_set(uint8_t shift);
 void auto_clock_speed();
 #endif
 
@@ -82,7 +82,9 @@ inline void PCINT_off() {
     #error Unrecognized MCU type
 #endif
 
-    irq_pcint = 1;  // let deferred code know an interrupt happened
+    FSM_PROBE(PROBE_PCINT_ISR);
+    irq_post(IRQ_PCINT);  // let deferred code know an interrupt happened
+    FSM_PROBE_END(PROBE_PCINT_ISR);
 
     //DEBUG_FLASH;
 
@@ -97,6 +99,9 @@ inline void PCINT_off() {
 // (is a separate function to reduce code duplication)
 void PCINT_inner(uint8_t pressed) {
     button_last_state = pressed;
+    // any button change cancels standby, even one which comes after the
+    // UI asked for it, but before the main loop went to sleep
+    go_to_standby = 0;
 
     // register the change, and send event to the current state callback
     if (pressed) {  // user pressed button
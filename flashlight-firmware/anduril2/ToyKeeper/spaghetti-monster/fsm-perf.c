@@ -0,0 +1,39 @@
+/*
+ * fsm-perf.c: Performance counters for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_PERF_C
+#define FSM_PERF_C
+
+#ifdef USE_PERF_COUNTERS
+
+#include <avr/eeprom.h>
+
+void perf_snapshot(PerfCounters *copy) {
+    // (the ISRs update merged_ticks and irqs[])
+    cli();
+    *copy = perf;
+    sei();
+}
+
+void perf_save(PerfCounters *copy) {
+    // (only changed bytes are written, so this is cheap to repeat)
+    eeprom_update_block(copy, (void *)PERF_EEP_ADDR, sizeof(*copy));
+}
+
+#endif
+
+#endif
@@ -0,0 +1,84 @@
+/*
+ * fsm-perf.h: Performance counters for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_PERF_H
+#define FSM_PERF_H
+
+#ifdef USE_PERF_COUNTERS
+
+#include "fsm-main.h"  // for IRQ_SOURCES
+
+// counts things which are otherwise invisible: a full event queue,
+// clock ticks handled late, time spent dozing, LVP and thermal events,
+// and how often each interrupt fired
+// (all counters wrap around, and all start at 0 on each power-up)
+// bin/perf_decode.py reads this from an EEPROM dump (see perf_save()),
+// so if the layout changes, change PERF_MAGIC and the decoder too
+#define PERF_MAGIC 0xc2
+typedef struct {
+    uint8_t magic;           // PERF_MAGIC, to recognize it in a dump
+    uint8_t queue_max;       // most events ever waiting in emissions[]
+    uint16_t dropped;        // events lost because emissions[] was full
+    uint16_t merged_ticks;   // ticks which came before the last was handled
+    uint16_t late_ticks;     // ticks which came while WDT_inner() ran,
+                             // or while save_eeprom() had interrupts off
+    uint32_t awake_ticks;    // clock ticks while awake
+    uint32_t idle_ticks;     // ... which dozed in idle_mode() at least once
+    uint32_t sleep_ticks;    // clock ticks (wake-ups) in standby
+    uint16_t lvp_events;     // LVP cutoffs / step-downs
+    uint16_t thermal_events; // EV_temperature_high / _low sent
+    uint16_t irqs[IRQ_SOURCES];  // interrupts posted, per IRQ_* source
+} PerfCounters;
+PerfCounters perf = { .magic = PERF_MAGIC };
+// set by idle_mode(), cleared each tick
+uint8_t perf_dozed = 0;
+
+#define perf_count(field) (perf.field ++)
+#define perf_max(field, value) do { \
+    if ((value) > perf.field) perf.field = (value); \
+    } while (0)
+
+// has the WDT (or PIT) interrupt fired, but not been serviced yet?
+#if (ATTINY == 25) || (ATTINY == 45) || (ATTINY == 85)
+#define WDT_irq_waiting() (WDTCR & (1<<WDIF))
+#elif (ATTINY == 1634)
+#define WDT_irq_waiting() (WDTCSR & (1<<WDIF))
+#elif defined(AVRXMEGA3)  // ATTINY816, 817, etc
+#define WDT_irq_waiting() (RTC.PITINTFLAGS & RTC_PI_bm)
+#endif
+
+// where perf_save() puts a copy, at the very end of EEPROM
+#define PERF_EEP_ADDR (EEPSIZE - sizeof(PerfCounters))
+// copy the counters with interrupts off (the ISRs update some of them)
+void perf_snapshot(PerfCounters *copy);
+// copy the counters to EEPROM, so they can be read over ISP
+void perf_save(PerfCounters *copy);
+
+// perf_blink() (in the UI's readout mode) needs this
+#define USE_BLINK_BIG_NUM
+#ifndef USE_BLINK_DIGIT
+#define USE_BLINK_DIGIT
+#endif
+
+#else
+
+#define perf_count(field)
+#define perf_max(field, value)
+
+#endif  // ifdef USE_PERF_COUNTERS
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * fsm-probe.h: Timing probes and event tracing for SpaghettiMonster debug
+ * builds.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_PROBE_H
+#define FSM_PROBE_H
+
+// Probes mark where the hot paths start and end, so their timing can be
+// seen from outside: ISR latency, busy time, and sleep residency.
+// Without USE_PROBES, they compile to nothing.
+// With USE_PROBES, each probe either:
+// - writes to a RAM trace ring (USE_PROBE_TRACE, the default),
+//   which bin/fsm-sim.c can turn into a VCD file, or
+// - drives a spare pin (PROBE_PIN, PROBE_PORT, PROBE_DDR), for a scope or
+//   logic analyzer on a real light.  The pin is high while any probe in
+//   PROBE_PIN_MASK is active (default: all of them).
+// Both can be on at once.  Probes cost a few cycles each, so timings
+// measured this way include a little overhead.
+
+// probe IDs (bin/fsm-sim.c has the same list, for its signal names)
+#define PROBE_WDT_ISR       0  // WDT_vect / RTC_PIT_vect
+#define PROBE_ADC_ISR       1  // ADC_vect
+#define PROBE_PCINT_ISR     2  // PCINT_vect / the switch's port vector
+#define PROBE_TIMER_ISR     3  // 4th PWM channel's timer interrupts
+#define PROBE_WDT_INNER     4  // WDT_inner()
+#define PROBE_ADC_DEFERRED  5  // adc_deferred()
+#define PROBE_EMISSIONS     6  // process_emissions()
+#define PROBE_SET_LEVEL     7  // set_level()
+#define PROBE_STANDBY       8  // the whole time in standby mode
+#define PROBE_SLEEP         9  // the CPU sleeping (standby, idle, ADC)
+#define PROBE_IDS          10
+#define PROBE_EXIT       0x80  // (set in the trace on the way out)
+
+#ifdef USE_PROBES
+
+#include <avr/interrupt.h>
+
+#if (! defined(PROBE_PIN)) && (! defined(USE_PROBE_TRACE))
+#define USE_PROBE_TRACE
+#endif
+
+#ifdef USE_PROBE_TRACE
+// each entry is a probe ID, plus PROBE_EXIT on the way out
+// (length must be a power of 2)
+#ifndef PROBE_TRACE_LEN
+#define PROBE_TRACE_LEN 16
+#endif
+#if PROBE_TRACE_LEN & (PROBE_TRACE_LEN - 1)
+#error PROBE_TRACE_LEN must be a power of 2
+#endif
+// (fsm-sim finds this by name, and its length by the symbol's size)
+volatile struct {
+    uint8_t head;  // where the next entry goes
+    uint8_t ring[PROBE_TRACE_LEN];
+} probe_trace;
+#endif
+
+#ifdef PROBE_PIN
+#ifndef PROBE_PIN_MASK
+#define PROBE_PIN_MASK 0xffff
+#endif
+// how many probes in PROBE_PIN_MASK are active
+// (an ISR always puts this back the way it was, so main code can
+//  change it without turning interrupts off)
+volatile uint8_t probe_depth = 0;
+#endif
+
+static inline void probe_mark(uint8_t event) {
+    #ifdef USE_PROBE_TRACE
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t head = probe_trace.head;
+    probe_trace.ring[head] = event;
+    probe_trace.head = (head + 1) & (PROBE_TRACE_LEN - 1);
+    SREG = sreg;
+    #endif
+    #ifdef PROBE_PIN
+    if ((1U << (event & ~PROBE_EXIT)) & PROBE_PIN_MASK) {
+        if (event & PROBE_EXIT) {
+            if (! --probe_depth) PROBE_PORT &= ~(1 << PROBE_PIN);
+        } else {
+            if (! probe_depth++) PROBE_PORT |= (1 << PROBE_PIN);
+        }
+    }
+    #endif
+}
+
+static inline uint8_t probe_begin(uint8_t id) {
+    probe_mark(id);
+    return id;
+}
+static inline void probe_end(uint8_t *id) {
+    probe_mark(*id | PROBE_EXIT);
+}
+
+static inline void probe_setup() {
+    #ifdef PROBE_PIN
+    PROBE_DDR |= (1 << PROBE_PIN);
+    #endif
+}
+
+// FSM_PROBE(id) ... FSM_PROBE_END(id) marks a stretch of code,
+// and FSM_PROBE_SCOPE(id) marks the rest of the enclosing block,
+// however it exits (for functions with more than one return)
+#define FSM_PROBE(id) probe_mark(id)
+#define FSM_PROBE_END(id) probe_mark((id) | PROBE_EXIT)
+#define FSM_PROBE_SCOPE(id) \
+    uint8_t probe_scope __attribute__((cleanup(probe_end))) = probe_begin(id)
+
+#else  // no probes
+
+#define FSM_PROBE(id)
+#define FSM_PROBE_END(id)
+#define FSM_PROBE_SCOPE(id)
+#define probe_setup()
+
+#endif  // ifdef USE_PROBES
+
+// With USE_EVENT_TRACE, every event the UI gets and every state change
+// goes to a RAM ring too, so bin/ui_trace.py can record what the UI did
+// in simavr, and compare it against an earlier recording.
+#ifdef USE_EVENT_TRACE
+
+#include <avr/interrupt.h>
+
+// (length must be a power of 2)
+#ifndef EVENT_TRACE_LEN
+#define EVENT_TRACE_LEN 8
+#endif
+#if EVENT_TRACE_LEN & (EVENT_TRACE_LEN - 1)
+#error EVENT_TRACE_LEN must be a power of 2
+#endif
+// an entry with event 0 (EV_none) is a state change, and its arg is the
+// new state function's address
+// (fsm-sim finds this by name, and its length by the symbol's size)
+volatile struct {
+    uint8_t head;  // where the next entry goes
+    struct {
+        uint8_t event;
+        uint16_t arg;
+    } ring[EVENT_TRACE_LEN];
+} event_trace;
+
+static inline void trace_event(uint8_t event, uint16_t arg) {
+    uint8_t sreg = SREG;
+    cli();
+    uint8_t head = event_trace.head;
+    event_trace.ring[head].event = event;
+    event_trace.ring[head].arg = arg;
+    event_trace.head = (head + 1) & (EVENT_TRACE_LEN - 1);
+    SREG = sreg;
+}
+
+#define FSM_TRACE_EVENT(event, arg) trace_event(event, arg)
+#define FSM_TRACE_STATE(state) trace_event(0, (uint16_t)(state))
+
+#else
+
+#define FSM_TRACE_EVENT(event, arg)
+#define FSM_TRACE_STATE(state)
+
+#endif  // ifdef USE_EVENT_TRACE
+
+#endif
@@ -24,6 +24,7 @@
 #ifdef USE_RAMPING
 
 void set_level(uint8_t level) {
+    FSM_PROBE_SCOPE(PROBE_SET_LEVEL);
     #ifdef USE_JUMP_START
     // maybe "jump start" the engine, if it's prone to slow starts
     // (pulse the output high for a moment to wake up the power regulator)
@@ -22,34 +22,98 @@
 
 #include <avr/interrupt.h>
 #include <avr/sleep.h>
+#ifdef USE_FAST_WAKE
+#include <util/delay_basic.h>
+#endif
 
 #include "fsm-adc.h"
 #include "fsm-wdt.h"
 #include "fsm-pcint.h"
 
+#ifdef USE_ADAPTIVE_STANDBY
+void standby_wake_in(uint16_t ticks) {
+    if (ticks < standby_wake_ticks) standby_wake_ticks = ticks;
+}
+
+// pick the slowest WDT speed which doesn't sleep past anything
+static inline void standby_adapt() {
+    uint16_t wake = standby_wake_ticks;
+    #ifdef USE_SLEEP_LVP
+    // sleep LVP happens every 64 sleep ticks
+    uint8_t lvp = 64 - (ticks_since_last_event & 0x3f);
+    if (lvp < wake) wake = lvp;
+    #endif
+    // (steps are powers of 2, so they always land exactly on the deadline)
+    uint8_t speed = STANDBY_TICK_SPEED;
+    uint8_t step = 1;
+    while ((speed < STANDBY_TICK_SPEED_MAX) && ((step << 1) <= wake)) {
+        speed ++;
+        step <<= 1;
+    }
+    if (speed != standby_tick_speed) {
+        standby_tick_speed = speed;
+        standby_tick_step = step;
+        WDT_slow();
+    }
+}
+#endif
+
+#ifdef USE_FAST_WAKE
+// is the switch held down, steadily?
+// (reads the pin directly, so a bounce which fails this doesn't change
+//  button_last_state, and the WDT still sees it as a new press later)
+static inline uint8_t fast_wake_pressed() {
+    for (uint8_t i = 0; i < FAST_WAKE_SAMPLES; i++) {
+        if (SWITCH_PORT & (1<<SWITCH_PIN)) return 0;
+        #ifdef USE_DYNAMIC_UNDERCLOCKING
+        _delay_loop_2((BOGOMIPS/4) >> clock_speed_shift);
+        #else
+        _delay_loop_2(BOGOMIPS/4);
+        #endif
+    }
+    return 1;
+}
+#endif
+
 // low-power standby mode used while off but power still connected
 #define standby_mode sleep_until_eswitch_pressed
 void sleep_until_eswitch_pressed()
 {
+    FSM_PROBE(PROBE_STANDBY);
+    #ifdef USE_TELEMETRY
+    // (the only time the usage log is written)
+    telemetry_save();
+    #endif
     #ifdef TICK_DURING_STANDBY
+    #ifdef USE_ADAPTIVE_STANDBY
+    // start at the normal speed, until the UI says what it needs
+    standby_tick_speed = STANDBY_TICK_SPEED;
+    standby_tick_step = 1;
+    #endif
     WDT_slow();
     #else
     WDT_off();
     #endif
 
     ADC_off();
+    #ifdef PRR_USED
+    PRR = PRR_STANDBY;  // stop peripherals while asleep
+    #endif
 
     // make sure switch isn't currently pressed
     while (button_is_pressed()) {}
     empty_event_sequence();  // cancel pending input on suspend
+    #if defined(USE_SECONDS_CLOCK) && defined(TICK_DURING_STANDBY)
+    standby_start_seconds = clock_seconds;
+    #endif
 
     PCINT_on();  // wake on e-switch event
 
     #ifdef TICK_DURING_STANDBY
-    // detect which type of event caused a wake-up
-    irq_adc = 0;
-    irq_wdt = 0;
-    irq_pcint = 0;
+    // forget anything which happened before sleeping
+    irq_done(IRQ_ADC);
+    irq_done(IRQ_WDT);
+    irq_done(IRQ_PCINT);
     while (go_to_standby) {
     #else
         go_to_standby = 0;
@@ -59,34 +123,36 @@ void sleep_until_eswitch_pressed()
         set_sleep_mode(SLEEP_MODE_PWR_DOWN);
 
         sleep_enable();
+        // (before the BOD disable: the sleep has to follow it within 3
+        //  cycles, so nothing can go between them, not even a probe)
+        FSM_PROBE(PROBE_SLEEP);
         #ifdef BODCR  // only do this on MCUs which support it
         sleep_bod_disable();
         #endif
+        // (attiny1634 BOD is fuse-only, and 1-series BOD is set in hw_setup)
         sleep_cpu();  // wait here
+        FSM_PROBE_END(PROBE_SLEEP);
 
         // something happened; wake up
         sleep_disable();
 
     #ifdef TICK_DURING_STANDBY
-        // determine what woke us up...
-        if (irq_pcint) {  // button pressed; wake up
-            go_to_standby = 0;
-        }
-        if (irq_adc) {  // ADC done measuring
-            #ifndef USE_LOWPASS_WHILE_ASLEEP
-            adc_reset = 1;  // don't lowpass while asleep
-            #endif
-            adc_deferred_enable = 1;
-            adc_deferred();
-            //ADC_off();  // takes care of itself
-            //irq_adc = 0;  // takes care of itself
-        }
-        if (irq_wdt) {  // generate a sleep tick
-            WDT_inner();
-        }
+        // handle whatever woke us up, the same way as while awake
+        // (a button press ends standby, a WDT tick becomes a sleep tick,
+        //  and sleep LVP measurements are started by the sleep tick)
+        #ifdef USE_ADAPTIVE_STANDBY
+        if (handle_deferred_interrupts() & (1 << IRQ_WDT))
+            standby_adapt();
+        #else
+        handle_deferred_interrupts();
+        #endif
     }
     #endif
 
+    #ifdef USE_ADAPTIVE_STANDBY
+    standby_tick_step = 1;  // back to 1 tick per WDT interrupt
+    #endif
+
     // don't lowpass immediately after waking
     // also, reset thermal history
     adc_reset = 2;
@@ -95,9 +161,24 @@ void sleep_until_eswitch_pressed()
     // PCINT not needed any more, and can cause problems if on
     // (occasional reboots on wakeup-by-button-press)
     PCINT_off();
+    // (and a bounce right before PCINT_off() shouldn't cancel the next standby)
+    irq_done(IRQ_PCINT);
+    #ifdef PRR_USED
+    PRR = PRR_AWAKE;  // restart peripherals (before using them)
+    #endif
+    #ifdef USE_FAST_WAKE
+    // handle the press now instead of on the next WDT tick (16ms later),
+    // and before restarting the ADC, so the light turns on first
+    // (unless a sleep tick already saw it, or it isn't a steady press)
+    if ((! button_last_state) && fast_wake_pressed()) {
+        PCINT_inner(1);
+        process_emissions();
+    }
+    #endif
     // restore normal awake-mode interrupts
     ADC_on();
     WDT_on();
+    FSM_PROBE_END(PROBE_STANDBY);
 }
 
 #ifdef USE_IDLE_MODE
@@ -107,10 +188,15 @@ void idle_mode()
     set_sleep_mode(SLEEP_MODE_IDLE);
 
     sleep_enable();
+    FSM_PROBE(PROBE_SLEEP);
     sleep_cpu();  // wait here
+    FSM_PROBE_END(PROBE_SLEEP);
 
     // something happened; wake up
     sleep_disable();
+    #ifdef USE_PERF_COUNTERS
+    perf_dozed = 1;
+    #endif
 }
 #endif
 
@@ -25,6 +25,15 @@
 // set this to nonzero to enter standby mode next time the system is idle
 volatile uint8_t go_to_standby = 0;
 
+#ifdef USE_FAST_WAKE
+// the waking press is handled right away if it reads "pressed" this many
+// times in a row, 0.25ms apart ... otherwise (a bounce or a glitch), it's
+// left for the next WDT tick, like without USE_FAST_WAKE
+#ifndef FAST_WAKE_SAMPLES
+#define FAST_WAKE_SAMPLES 8
+#endif
+#endif
+
 #ifdef TICK_DURING_STANDBY
 #ifndef STANDBY_TICK_SPEED
 #define STANDBY_TICK_SPEED 3  // every 0.128 s
@@ -70,6 +79,39 @@ volatile uint8_t go_to_standby = 0;
 #define SLEEP_TICKS_PER_SECOND 1
 #define SLEEP_TICKS_PER_MINUTE 57
 
+#endif
+
+#ifdef USE_ADAPTIVE_STANDBY
+// sleep longer than STANDBY_TICK_SPEED when nothing needs a sleep tick,
+// by moving the WDT / PIT to a slower speed and counting each wake-up
+// as several sleep ticks (so EV_sleep_tick's arg still counts normal ticks)
+#if (STANDBY_TICK_SPEED > 6)
+#error USE_ADAPTIVE_STANDBY needs STANDBY_TICK_SPEED 6 or less
+#endif
+// slowest available speed, same units as STANDBY_TICK_SPEED
+#ifdef AVRXMEGA3  // ATTINY816, 817, etc
+#define STANDBY_TICK_SPEED_MAX 6  // 1.0 s, limited by the PIT
+#else
+#define STANDBY_TICK_SPEED_MAX 9  // 8.0 s
+#endif
+uint8_t standby_tick_speed = STANDBY_TICK_SPEED;
+// how many sleep ticks each wake-up counts as
+uint8_t standby_tick_step = 1;
+// sleep ticks until the UI needs its next EV_sleep_tick
+// (reset before each sleep tick, so the UI must set it every time,
+//  with standby_wake_in(), or it'll only wake for sleep LVP)
+uint16_t standby_wake_ticks;
+void standby_wake_in(uint16_t ticks);
+#endif
+#endif
+
+#ifdef AVRXMEGA3  // ATTINY816, 817, etc
+// brown-out detection while asleep (in standby, and idle mode if used)
+// (the BODCFG fuse sets it while awake, but sleep mode is writable, and
+//  continuous BOD costs ~20uA, sampled ~1uA, off nothing)
+// BOD_SLEEP_DIS_gc, BOD_SLEEP_SAMPLED_gc, or BOD_SLEEP_ENABLED_gc
+#ifndef BOD_SLEEP
+#define BOD_SLEEP BOD_SLEEP_DIS_gc
 #endif
 #endif
 
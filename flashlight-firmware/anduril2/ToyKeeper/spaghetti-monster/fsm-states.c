@@ -37,6 +37,7 @@ void _set_state(StatePtr new_state, uint16_t arg,
     if (current_state != NULL) current_state(exit_event, arg);
     // set new state
     current_state = new_state;
+    FSM_TRACE_STATE(new_state);
     // call new state-enter hook (don't use stack)
     if (new_state != NULL) current_state(enter_event, arg);
 
@@ -95,6 +96,15 @@ uint8_t default_state(Event event, uint16_t arg) {
 
     #ifdef USE_LVP
     else if (event == EV_voltage_low) {
+        #ifdef USE_SMOOTH_LVP
+        // battery empty: off, not the per-state step-down
+        if (arg == LVP_HARD_CUTOFF) {
+            lvp_hard_cutoff();
+            return EVENT_HANDLED;
+        }
+        // early warnings are only for states which adjust gradually
+        if (arg) return EVENT_HANDLED;
+        #endif
         low_voltage();
         return EVENT_HANDLED;
     }
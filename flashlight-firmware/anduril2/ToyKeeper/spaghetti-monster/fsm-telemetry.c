@@ -0,0 +1,126 @@
+/*
+ * fsm-telemetry.c: Persistent usage log for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_TELEMETRY_C
+#define FSM_TELEMETRY_C
+
+#ifdef USE_TELEMETRY
+
+#include <avr/eeprom.h>
+
+_Static_assert(TELEMETRY_SLOTS > 0,
+               "USE_TELEMETRY needs more spare EEPROM than this build has");
+
+#define telemetry_slot_addr(slot) \
+    ((uint8_t *)(TELEMETRY_START + (slot) * sizeof(TelemetryRecord)))
+
+static uint8_t telemetry_checksum(uint8_t *data) {
+    uint8_t sum = TELEMETRY_MAGIC;
+    for (uint8_t i=0; i<sizeof(TelemetryRecord)-1; i++) sum += data[i];
+    return sum;
+}
+
+void telemetry_load() {
+    uint8_t *data = (uint8_t *)&telemetry;
+    uint8_t found = 0;
+    uint8_t newest = 0;
+    for (uint8_t slot=0; slot<TELEMETRY_SLOTS; slot++) {
+        TelemetryRecord rec;
+        eeprom_read_block(&rec, telemetry_slot_addr(slot), sizeof(rec));
+        if ((rec.magic != TELEMETRY_MAGIC)
+                || (rec.checksum != telemetry_checksum((uint8_t *)&rec)))
+            continue;
+        // (seq wraps, so compare by subtracting)
+        if ((! found) || ((int8_t)(rec.seq - newest) > 0)) {
+            found = 1;
+            newest = rec.seq;
+            telemetry_slot = slot;
+            telemetry = rec;
+        }
+    }
+    if (! found) {  // blank: start from zero
+        for (uint8_t i=0; i<sizeof(TelemetryRecord); i++) data[i] = 0;
+        telemetry.magic = TELEMETRY_MAGIC;
+        telemetry.max_temperature = -128;
+        telemetry.min_voltage = 255;
+        // (so the first save goes to slot 0)
+        telemetry_slot = TELEMETRY_SLOTS - 1;
+    }
+    telemetry_count(boots);
+}
+
+void telemetry_tick() {
+    #ifdef USE_THERMAL_REGULATION
+    if (temperature > telemetry.max_temperature) {
+        // (the ADC's idea of temperature never goes past an int8 anyway)
+        telemetry.max_temperature = (temperature < 127) ? temperature : 127;
+    }
+    #endif
+
+    if (! actual_level) return;
+
+    #ifdef USE_LVP
+    #ifdef USE_BATT_IR_COMPENSATION
+    uint8_t v = voltage_loaded;  // what the cell actually sagged to
+    #else
+    uint8_t v = voltage;
+    #endif
+    if (v && (v < telemetry.min_voltage)) telemetry.min_voltage = v;
+    #endif
+
+    // everything else counts seconds
+    #ifdef USE_SECONDS_CLOCK
+    // follow the clock, so seconds don't drift from the real 62.5 Hz rate
+    if ((uint8_t)clock_seconds == telemetry_ticks) return;
+    telemetry_ticks = clock_seconds;
+    #else
+    // the WDT runs at 62.5 Hz, so count half-ticks
+    telemetry_ticks += 2;
+    if (telemetry_ticks < (TICKS_PER_SECOND*2)+1) return;
+    telemetry_ticks -= (TICKS_PER_SECOND*2)+1;
+    #endif
+
+    uint8_t band = (uint16_t)(actual_level - 1) * TELEMETRY_BANDS / RAMP_SIZE;
+    telemetry.band_seconds[band] ++;
+    if (actual_level >= RAMP_SIZE) telemetry.turbo_seconds ++;
+    #ifdef USE_THERMAL_REGULATION
+    if (telemetry_throttled()) telemetry.throttle_seconds ++;
+    #endif
+    telemetry_unsaved ++;
+}
+
+void telemetry_save() {
+    if ((! telemetry_event) && (telemetry_unsaved < TELEMETRY_SAVE_SECONDS))
+        return;
+    telemetry_event = 0;
+    telemetry_unsaved = 0;
+
+    // write to the slot after the newest one, checksum last
+    uint8_t slot = telemetry_slot + 1;
+    if (slot >= TELEMETRY_SLOTS) slot = 0;
+    telemetry_slot = slot;
+    telemetry.seq ++;
+    telemetry.checksum = telemetry_checksum((uint8_t *)&telemetry);
+    uint8_t *data = (uint8_t *)&telemetry;
+    uint8_t *addr = telemetry_slot_addr(slot);
+    for (uint8_t i=0; i<sizeof(TelemetryRecord); i++)
+        eeprom_update_byte(addr + i, data[i]);
+}
+
+#endif
+
+#endif
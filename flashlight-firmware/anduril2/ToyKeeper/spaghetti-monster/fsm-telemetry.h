@@ -0,0 +1,88 @@
+/*
+ * fsm-telemetry.h: Persistent usage log for SpaghettiMonster.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FSM_TELEMETRY_H
+#define FSM_TELEMETRY_H
+
+#ifdef USE_TELEMETRY
+
+// lifetime usage totals, kept in the spare EEPROM after the UI's config
+// (for figuring out what happened to a light which came back broken)
+// The spare space holds as many copies (slots) as fit, and each save goes
+// to the next slot, so the writes are spread out, and a save interrupted
+// by power loss leaves the previous copy intact.
+// bin/telemetry_decode.py reads this from an EEPROM dump, so if the
+// layout changes, change TELEMETRY_MAGIC and the decoder too.
+#define TELEMETRY_MAGIC 0x7e
+#define TELEMETRY_BANDS 4  // the ramp is split into this many bands
+typedef struct {
+    uint8_t magic;             // TELEMETRY_MAGIC
+    uint8_t seq;               // save number (wraps), the newest slot wins
+    uint16_t boots;            // times power was connected
+    uint32_t band_seconds[TELEMETRY_BANDS];  // time on, lowest band first
+    uint32_t turbo_seconds;    // time at the top of the ramp
+    uint32_t throttle_seconds; // time stepped down by thermal regulation
+    uint16_t lvp_events;       // low voltage cutoffs / step-downs
+    int8_t max_temperature;    // hottest seen while awake, in C
+    uint8_t min_voltage;       // lowest seen while on, in tenths of a volt
+    uint8_t checksum;          // (written last)
+} TelemetryRecord;
+TelemetryRecord telemetry;
+
+// saves are batched: at standby, but only after an event (boot, LVP),
+// or once at least this much on-time has piled up
+#ifndef TELEMETRY_SAVE_SECONDS
+#define TELEMETRY_SAVE_SECONDS 60
+#endif
+uint8_t telemetry_event = 0;     // something happened which should be saved
+uint16_t telemetry_unsaved = 0;  // seconds of on-time not saved yet
+uint8_t telemetry_ticks = 0;     // half-ticks into the current second,
+                                 // or the clock's last second (low byte)
+uint8_t telemetry_slot = 0;      // where the newest copy is
+
+// the space after the UI's config (and before the perf counters)
+#define TELEMETRY_START (EEP_START + 1 + EEPROM_BYTES)
+#ifdef USE_PERF_COUNTERS
+#define TELEMETRY_END PERF_EEP_ADDR
+#else
+#define TELEMETRY_END EEPSIZE
+#endif
+#define TELEMETRY_SLOTS \
+    ((TELEMETRY_END - TELEMETRY_START) / sizeof(TelemetryRecord))
+
+// read the newest copy, and count a boot (call once at boot)
+void telemetry_load();
+// call once per awake tick
+void telemetry_tick();
+// save, if it's time (call when entering standby)
+void telemetry_save();
+#define telemetry_count(field) do { \
+    telemetry.field ++; telemetry_event = 1; \
+    } while (0)
+
+#if defined(USE_THERMAL_REGULATION)
+// the UI defines this: is the output currently stepped down for heat?
+uint8_t telemetry_throttled();
+#endif
+
+#else
+
+#define telemetry_count(field)
+
+#endif  // ifdef USE_TELEMETRY
+
+#endif
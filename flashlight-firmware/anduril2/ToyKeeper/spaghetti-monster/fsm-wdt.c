@@ -29,6 +29,9 @@
 
 void WDT_on()
 {
+    #ifdef USE_SECONDS_CLOCK
+    clock_wdt_ticks = 1;
+    #endif
     #if (ATTINY == 25) || (ATTINY == 45) || (ATTINY == 85)
         // interrupt every 16ms
         //cli();                          // Disable interrupts
@@ -51,20 +54,37 @@ void WDT_on()
 #ifdef TICK_DURING_STANDBY
 inline void WDT_slow()
 {
+    #ifdef USE_ADAPTIVE_STANDBY
+    uint8_t speed = standby_tick_speed;
+    #ifndef AVRXMEGA3
+    // the WDT's 4th prescaler bit is in the "32" position
+    speed = (speed & 7) | ((speed & 8) << 2);
+    #endif
+    #else
+    uint8_t speed = STANDBY_TICK_SPEED;
+    #endif
+    #ifdef USE_SECONDS_CLOCK
+    // each sleep tick is 2^STANDBY_TICK_SPEED awake ticks
+    #ifdef USE_ADAPTIVE_STANDBY
+    clock_wdt_ticks = (uint16_t)standby_tick_step << STANDBY_TICK_SPEED;
+    #else
+    clock_wdt_ticks = 1 << STANDBY_TICK_SPEED;
+    #endif
+    #endif
     #if (ATTINY == 25) || (ATTINY == 45) || (ATTINY == 85)
         // interrupt slower
         //cli();                          // Disable interrupts
         wdt_reset();                    // Reset the WDT
         WDTCR |= (1<<WDCE) | (1<<WDE);  // Start timed sequence
-        WDTCR = (1<<WDIE) | STANDBY_TICK_SPEED; // Enable interrupt every so often
+        WDTCR = (1<<WDIE) | speed;      // Enable interrupt every so often
         //sei();                          // Enable interrupts
     #elif (ATTINY == 1634)
         wdt_reset();                    // Reset the WDT
-        WDTCSR = (1<<WDIE) | STANDBY_TICK_SPEED;
+        WDTCSR = (1<<WDIE) | speed;
     #elif defined(AVRXMEGA3)  // ATTINY816, 817, etc
         RTC.PITINTCTRL = RTC_PI_bm;   // enable the Periodic Interrupt
         while (RTC.PITSTATUS > 0) {}  // make sure the register is ready to be updated
-        RTC.PITCTRLA = (1<<6) | (STANDBY_TICK_SPEED<<3) | RTC_PITEN_bm; // Set period, enable the PI Timer
+        RTC.PITCTRLA = (1<<6) | (speed<<3) | RTC_PITEN_bm; // Set period, enable the PI Timer
     #else
         #error Unrecognized MCU type
     #endif
@@ -102,27 +122,52 @@ ISR(RTC_PIT_vect) {
 #else
 ISR(WDT_vect) {
 #endif
-    irq_wdt = 1;  // WDT event happened
+    FSM_PROBE(PROBE_WDT_ISR);
+    #ifdef USE_PERF_COUNTERS
+    if (irq_pending(IRQ_WDT)) perf_count(merged_ticks);
+    #endif
+    #ifdef USE_SECONDS_CLOCK
+    clock_isr();  // count every tick, even if WDT_inner() misses some
+    #endif
+    irq_post(IRQ_WDT);  // WDT event happened
+    FSM_PROBE_END(PROBE_WDT_ISR);
 }
 
 void WDT_inner() {
-    irq_wdt = 0;  // WDT event handled; reset flag
-
+    FSM_PROBE_SCOPE(PROBE_WDT_INNER);
     static uint8_t adc_trigger = 0;
 
     // cache this here to reduce ROM size, because it's volatile
     uint16_t ticks_since_last = ticks_since_last_event;
     // increment, but loop from max back to half
+    #ifdef USE_ADAPTIVE_STANDBY
+    // (while asleep, each interrupt may be worth several ticks)
+    ticks_since_last = (ticks_since_last + standby_tick_step) \
+                     | (ticks_since_last & 0x8000);
+    #else
     ticks_since_last = (ticks_since_last + 1) \
                      | (ticks_since_last & 0x8000);
+    #endif
     // copy back to the original
     ticks_since_last_event = ticks_since_last;
 
+    #ifdef USE_PERF_COUNTERS
+    if (go_to_standby) perf_count(sleep_ticks);
+    else {
+        perf_count(awake_ticks);
+        if (perf_dozed) perf_count(idle_ticks);
+    }
+    perf_dozed = 0;
+    #endif
+
+    #ifdef USE_SECONDS_CLOCK
+    clock_update();
+    #endif
+
     // detect and emit button change events (even during standby)
     uint8_t was_pressed = button_last_state;
     uint8_t pressed = button_is_pressed();
     if (was_pressed != pressed) {
-        go_to_standby = 0;
         PCINT_inner(pressed);
     }
     // cache again, in case the value changed
@@ -131,23 +176,48 @@ void WDT_inner() {
     #ifdef TICK_DURING_STANDBY
     // handle standby mode specially
     if (go_to_standby) {
+        #ifdef USE_ADAPTIVE_STANDBY
+        standby_wake_ticks = 0xffff;  // the UI sets this during the tick
+        #endif
         // emit a sleep tick, and process it
         emit(EV_sleep_tick, ticks_since_last);
         process_emissions();
 
+        #ifdef USE_ENERGY_METER
+        energy_sleep_tick();
+        #endif
+
         #ifndef USE_SLEEP_LVP
         return;  // no sleep LVP needed if nothing drains power while off
         #else
         // stop here, usually...  but proceed often enough for sleep LVP to work
         if (0 != (ticks_since_last & 0x3f)) return;
 
+        #ifndef USE_LOWPASS_WHILE_ASLEEP
+        adc_reset = 1;  // don't lowpass while asleep
+        #endif
+        #ifdef USE_ADC_SLEEP
+        // measure now, and the dispatcher handles the result right after
+        adc_deferred_enable = 1;
+        ADC_sleep_measure();
+        return;
+        #else
         adc_trigger = 0;  // make sure a measurement will happen
         ADC_on();  // enable ADC voltage measurement functions temporarily
         #endif
+        #endif
     }
     else {  // button handling should only happen while awake
     #endif
 
+    #ifdef USE_ENERGY_METER
+    energy_tick();
+    #endif
+
+    #ifdef USE_TELEMETRY
+    telemetry_tick();
+    #endif
+
     // if time since last event exceeds timeout,
     // append timeout to current event sequence, then
     // send event to current state callback
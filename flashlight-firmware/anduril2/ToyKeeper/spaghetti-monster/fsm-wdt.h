@@ -25,13 +25,14 @@
 void WDT_on();
 inline void WDT_off();
 
-volatile uint8_t irq_wdt = 0;  // WDT interrupt happened?
-
 #ifdef TICK_DURING_STANDBY
   #if defined(USE_INDICATOR_LED) || defined(USE_AUX_RGB_LEDS)
   // measure battery charge while asleep
   #define USE_SLEEP_LVP
   #endif
 #endif
+#if defined(USE_ADC_SLEEP) && !defined(USE_SLEEP_LVP)
+#undef USE_ADC_SLEEP  // nothing to measure while asleep
+#endif
 
 #endif
@@ -23,6 +23,7 @@
  */
 
 #include "tk-attiny.h"
+#include "fsm-probe.h"
 
 #include <avr/eeprom.h>
 #include <avr/power.h>
@@ -36,6 +37,10 @@
 #include "fsm-standby.h"
 #include "fsm-ramping.h"
 #include "fsm-random.h"
+#include "fsm-energy.h"
+#include "fsm-clock.h"
+#include "fsm-perf.h"
+#include "fsm-telemetry.h"
 #ifdef USE_EEPROM
 #include "fsm-eeprom.h"
 #endif
@@ -74,6 +79,10 @@ void loop();
 #include "fsm-standby.c"
 #include "fsm-ramping.c"
 #include "fsm-random.c"
+#include "fsm-energy.c"
+#include "fsm-clock.c"
+#include "fsm-perf.c"
+#include "fsm-telemetry.c"
 #ifdef USE_EEPROM
 #include "fsm-eeprom.c"
 #endif
@@ -147,11 +147,10 @@
 #elif defined(AVRXMEGA3)  // ATTINY816, 817, etc
     // this should work, but needs further validation
     inline void clock_prescale_set(uint8_t n) {
-        cli();         
-        CCP = CCP_IOREG_gc; // temporarily disable clock change protection
-        CLKCTRL.MCLKCTRLB = n; // Set the prescaler
+        // (the write must land within 4 cycles of unlocking CCP,
+        //  which _PROTECTED_WRITE guarantees and plain C doesn't)
+        _PROTECTED_WRITE(CLKCTRL.MCLKCTRLB, n); // Set the prescaler
         while (CLKCTRL.MCLKSTATUS & CLKCTRL_SOSC_bm) {} // wait for clock change to finish
-        sei();
     }
     typedef enum
     {
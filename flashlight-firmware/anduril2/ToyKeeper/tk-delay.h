@@ -36,7 +36,13 @@ void _delay_ms(uint16_t n)
     //    while(n-- > 0) _delay_loop_2(BOGOMIPS);
     //}
     //#else
+    #ifdef USE_DYNAMIC_UNDERCLOCKING
+    // fewer loops when the CPU is running slower
+    uint16_t loops = BOGOMIPS >> clock_speed_shift;
+    while(n-- > 0) _delay_loop_2(loops);
+    #else
     while(n-- > 0) _delay_loop_2(BOGOMIPS);
+    #endif
     //#endif
 }
 #endif
@@ -44,7 +50,11 @@ void _delay_ms(uint16_t n)
 #define delay_zero _delay_zero
 void _delay_zero() {
     //_delay_loop_2((BOGOMIPS/3) & 0xff00);
+    #ifdef USE_DYNAMIC_UNDERCLOCKING
+    _delay_loop_2(DELAY_ZERO_TIME >> clock_speed_shift);
+    #else
     _delay_loop_2(DELAY_ZERO_TIME);
+    #endif
 }
 #endif
 #ifdef USE_DELAY_4MS
@@ -52,7 +62,12 @@ void _delay_zero() {
 #define delay_4ms _delay_4ms
 void _delay_4ms(uint8_t n)  // because it saves a bit of ROM space to do it this way
 {
+    #ifdef USE_DYNAMIC_UNDERCLOCKING
+    uint16_t loops = (BOGOMIPS*4) >> clock_speed_shift;
+    while(n-- > 0) _delay_loop_2(loops);
+    #else
     while(n-- > 0) _delay_loop_2(BOGOMIPS*4);
+    #endif
 }
 #endif
 #endif
@@ -0,0 +1,341 @@
+"""What the bin/*.py tools share: finding Anduril's build targets and
+reading their configs, building them, looking inside the builds, and
+parsing options and printing tables the same way.
+
+Every AVR build goes through the Makefile next to anduril.c, out of
+tree (into a BUILD directory the caller picks), so the tools can run at
+the same time as each other and as a normal "make", and never leave
+files in the source tree.  Older trees (from git, or the open source
+Anduril) get built with this tree's Makefile, so they're built the same
+way as the current code.
+"""
+
+from __future__ import print_function
+
+import os
+import re
+import shutil
+import subprocess
+import tempfile
+from multiprocessing import cpu_count
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ANDURIL_DIR = os.path.join(HERE, '..', 'ToyKeeper', 'spaghetti-monster',
+                           'anduril')
+MAKEFILE = os.path.join(ANDURIL_DIR, 'Makefile')
+
+SERIES1 = (416, 417, 816, 817, 1616, 1617, 3216, 3217)
+STUB_HEADERS = ('avr/io.h', 'avr/eeprom.h', 'avr/interrupt.h',
+                'avr/pgmspace.h', 'avr/power.h', 'avr/sleep.h',
+                'avr/wdt.h', 'util/delay.h', 'util/delay_basic.h')
+
+# flash and RAM size, in bytes, per MCU
+MCU_SIZES = {
+    25: (2048, 128),
+    45: (4096, 256),
+    85: (8192, 512),
+    1634: (16384, 1024),
+    416: (4096, 256),
+    417: (4096, 256),
+    816: (8192, 512),
+    817: (8192, 512),
+    1616: (16384, 2048),
+    1617: (16384, 2048),
+    3216: (32768, 2048),
+    3217: (32768, 2048),
+}
+
+
+# *** targets and configs
+
+def find_cfgs(anduril_dir, pattern=None):
+    """Returns [(target, cfg file, mcu)] for every matching cfg-*.h."""
+    found = []
+    for cfg in sorted(os.listdir(anduril_dir)):
+        m = re.match(r'^cfg-(.*)\.h$', cfg)
+        if not m:
+            continue
+        if pattern and not re.search(pattern, cfg, re.IGNORECASE):
+            continue
+        found.append((m.group(1), cfg,
+                      get_mcu(os.path.join(anduril_dir, cfg))))
+    return found
+
+
+def get_mcu(path):
+    """Finds the "// ATTINY: N" line, like build-all.sh does."""
+    for line in open(path):
+        m = re.search(r'ATTINY:\s*(\d+)', line)
+        if m:
+            return int(m.group(1))
+    return 85
+
+
+def make_stubs():
+    """Makes a directory of empty AVR headers, so the host's cpp can
+    read the firmware.  The caller should remove it afterward."""
+    stubs = tempfile.mkdtemp()
+    for h in STUB_HEADERS + ('version.h',):
+        path = os.path.join(stubs, h)
+        if not os.path.isdir(os.path.dirname(path)):
+            os.makedirs(os.path.dirname(path))
+        open(path, 'w').close()
+    return stubs
+
+
+def get_macros(anduril_dir, stubs, cfg, mcu):
+    """Runs the preprocessor over anduril.c, returns the final macros."""
+    cmd = ['cpp', '-dM', '-DATTINY=%i' % mcu, '-DCONFIGFILE=%s' % cfg,
+           '-DE2END=0x3ff', '-I..', '-I../..', '-I../../..',
+           '-I%s' % stubs, 'anduril.c']
+    proc = subprocess.Popen(cmd, cwd=anduril_dir, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE)
+    out, err = proc.communicate()
+    if proc.returncode:
+        return None
+    macros = {}
+    for line in out.decode().splitlines():
+        m = re.match(r'^#define\s+(\w+)(\(.*?\))?\s*(.*)$', line)
+        if m and not m.group(2):
+            macros[m.group(1)] = m.group(3)
+    return macros
+
+
+def value(macros, name, default=None):
+    """Evaluates a numeric macro, or returns default."""
+    if name not in macros:
+        return default
+    text = macros[name]
+    for _ in range(8):  # expand nested macros
+        new = re.sub(r'\b([A-Za-z_]\w*)\b',
+                     lambda m: '(%s)' % macros.get(m.group(1), m.group(1)),
+                     text)
+        if new == text:
+            break
+        text = new
+    text = re.sub(r'\b(0x[0-9a-fA-F]+|\d+)[uUlL]+\b', r'\1', text)
+    text = text.replace('/', '//')
+    try:
+        return eval(text, {'__builtins__': {}})
+    except Exception:
+        return default
+
+
+def extract_revision(anduril_dir, rev, tmp):
+    """Unpacks the ToyKeeper directory at a git revision into tmp,
+    and returns the path of its anduril directory."""
+    top = git(anduril_dir, 'rev-parse', '--show-toplevel').strip()
+    prefix = git(anduril_dir, 'rev-parse', '--show-prefix').strip()
+    # the ToyKeeper directory, relative to the repo
+    tk = os.path.normpath(os.path.join(prefix, '..', '..'))
+    archive = subprocess.Popen(['git', '-C', top, 'archive', rev, tk],
+                               stdout=subprocess.PIPE)
+    subprocess.check_call(['tar', '-x', '-C', tmp], stdin=archive.stdout)
+    archive.wait()
+    return os.path.join(tmp, tk, 'spaghetti-monster', 'anduril')
+
+
+def git(cwd, *args):
+    return subprocess.check_output(('git', '-C', cwd) + args).decode()
+
+
+# *** building
+
+def build_targets(anduril_dir, names, build_dir, cppflags=(), jobs=None):
+    """Builds targets from anduril_dir into build_dir/<target>/, with the
+    Makefile, all at once.  Returns {target: ELF path, or None if it
+    didn't build}.  (Each set of cppflags needs its own build_dir.)"""
+    if not names:
+        return {}
+    build_dir = os.path.abspath(build_dir)
+    cmd = ['make', '-f', os.path.abspath(MAKEFILE), '-k',
+           '-j%i' % (jobs or cpu_count()), 'BUILD=%s' % build_dir,
+           'CPPFLAGS=%s' % ' '.join(cppflags), 'STACK_CHECK=',
+           'STAMP_VERSION='] + list(names)
+    proc = subprocess.Popen(cmd, cwd=anduril_dir, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT)
+    proc.communicate()
+    elfs = {}
+    for name in names:
+        elf = os.path.join(build_dir, name, 'anduril.elf')
+        elfs[name] = elf if os.path.exists(elf) else None
+    return elfs
+
+
+def sim_targets(anduril_dir, pattern):
+    """Reads every matching target's config, for simavr.  Returns
+    {target: {'mcu', 'macros'}}, or {target: {'mcu', 'error'}} for
+    targets which can't be simulated."""
+    stubs = make_stubs()
+    try:
+        targets = {}
+        for name, cfg, mcu in find_cfgs(anduril_dir, pattern):
+            t = {'mcu': mcu}
+            targets[name] = t
+            if mcu in SERIES1:
+                t['error'] = 'no simavr support'
+                continue
+            t['macros'] = get_macros(anduril_dir, stubs, cfg, mcu)
+            if t['macros'] is None:
+                t['error'] = 'preprocessor error'
+        return targets
+    finally:
+        shutil.rmtree(stubs)
+
+
+def build_sim_targets(anduril_dir, targets, build_dir, cppflags=(),
+                      jobs=None):
+    """Builds the targets from sim_targets() which don't have an error,
+    and adds each one's 'elf' (or an error, if it didn't build)."""
+    names = [n for n in sorted(targets) if 'error' not in targets[n]]
+    elfs = build_targets(anduril_dir, names, build_dir, cppflags, jobs)
+    for name in names:
+        if elfs[name]:
+            targets[name]['elf'] = elfs[name]
+        else:
+            targets[name]['error'] = 'build failed'
+
+
+def build_sim(tmp):
+    """Compiles fsm-sim.c for the host, returns the program's path."""
+    out = os.path.join(tmp, 'fsm-sim')
+    try:
+        flags = subprocess.check_output(
+            ['pkg-config', '--cflags', '--libs', 'simavr']).decode().split()
+    except (OSError, subprocess.CalledProcessError):
+        flags = ['-I/usr/include/simavr', '-I/usr/local/include/simavr',
+                 '-lsimavr']
+    cmd = ['cc', '-O2', '-o', out, os.path.join(HERE, 'fsm-sim.c')]
+    if subprocess.call(cmd + flags + ['-lelf']):
+        print('can\'t build fsm-sim (needs simavr and libelf)')
+        return None
+    return out
+
+
+# *** looking inside builds
+
+def section_sizes(elf):
+    """Returns (text, data, bss) in bytes."""
+    out = subprocess.check_output(['avr-size', '-A', elf]).decode()
+    sizes = {}
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0] in ('.text', '.data', '.bss'):
+            sizes[parts[0]] = int(parts[1])
+    return (sizes.get('.text', 0), sizes.get('.data', 0),
+            sizes.get('.bss', 0))
+
+
+def function_addresses(elf):
+    """Returns {symbol: flash byte address} for every function."""
+    out = subprocess.check_output(['avr-nm', elf]).decode()
+    symbols = {}
+    for line in out.splitlines():
+        m = re.match(r'^([0-9a-f]+) [tT] (\S+)$', line)
+        if m:
+            symbols[m.group(2)] = int(m.group(1), 16)
+    return symbols
+
+
+def data_symbol(elf, name):
+    """Returns (RAM address, size) of a variable, or None."""
+    out = subprocess.check_output(['avr-nm', '-S', elf]).decode()
+    for line in out.splitlines():
+        m = re.match(r'^([0-9a-f]+) ([0-9a-f]+) [bBdD] (\S+)$', line)
+        if m and m.group(3) == name:
+            # (data addresses are in avr-gcc's 0x800000 address space)
+            return int(m.group(1), 16) & 0xffff, int(m.group(2), 16)
+    return None
+
+
+_avr_macros = {}
+
+
+def avr_macros(mcu):
+    """Returns the lines avr-libc's <avr/io.h> defines for an MCU."""
+    if mcu not in _avr_macros:
+        proc = subprocess.Popen(['avr-gcc', '-mmcu=attiny%i' % mcu, '-E',
+                                 '-dM', '-x', 'c', '-'],
+                                stdin=subprocess.PIPE, stdout=subprocess.PIPE)
+        out, _ = proc.communicate(b'#include <avr/io.h>\n')
+        _avr_macros[mcu] = out.decode().splitlines()
+    return _avr_macros[mcu]
+
+
+def io_registers(mcu):
+    """Returns {name: (data address, bytes)} for the MCU's registers."""
+    registers = {}
+    for line in avr_macros(mcu):
+        m = re.match(r'^#define\s+(\w+)\s+_SFR_(IO|MEM)(8|16)\((0x[0-9a-fA-F]+)\)',
+                     line)
+        if m:
+            addr = int(m.group(4), 16)
+            if m.group(2) == 'IO':
+                addr += 0x20  # __SFR_OFFSET
+            registers[m.group(1)] = (addr, int(m.group(3)) // 8)
+    return registers
+
+
+def vector_names(mcu):
+    """Returns {"WDT_vect": "__vector_12", ...} for the MCU."""
+    vectors = {}
+    for line in avr_macros(mcu):
+        m = re.match(r'^#define\s+(\w+_vect)\s+_VECTOR\((\d+)\)', line)
+        if m:
+            vectors[m.group(1)] = '__vector_%s' % m.group(2)
+    return vectors
+
+
+# *** options and output
+
+def parse_args(args, options, usage):
+    """Parses "[options] [pattern]", the way all the tools take them.
+    options is {'--name': (key, convert, default)}, where convert is None
+    for a flag (which sets True), or a function for an option with a
+    value, which gets appended if the default is a list (repeatable).
+    Returns {key: value, 'pattern': pattern or None}, or None after
+    printing the usage text, if the args don't make sense."""
+    parsed = {'pattern': None}
+    for key, convert, default in options.values():
+        parsed[key] = list(default) if isinstance(default, list) else default
+    i = 0
+    while i < len(args):
+        a = args[i]
+        if a in options:
+            key, convert, default = options[a]
+            if convert is None:
+                parsed[key] = True
+            else:
+                i += 1
+                if i >= len(args):
+                    print(usage)
+                    return None
+                v = convert(args[i])
+                if isinstance(default, list):
+                    parsed[key].append(v)
+                else:
+                    parsed[key] = v
+        elif a.startswith('-') or parsed['pattern'] is not None:
+            print(usage)
+            return None
+        else:
+            parsed['pattern'] = a
+        i += 1
+    return parsed
+
+
+def print_table(columns, rows, csv=False):
+    """Prints rows of strings as CSV, or as a table with a header.
+    (the last cell of a short row, like an error, can stick out)"""
+    if csv:
+        print(','.join(columns))
+        for row in rows:
+            print(','.join(row))
+        return
+    rows = [list(columns)] + rows
+    widths = [max([len(row[i]) for row in rows
+                   if i < len(row) - 1 or len(row) == len(columns)] + [0])
+              for i in range(len(columns))]
+    for row in rows:
+        print('  '.join(cell.ljust(w) for cell, w in zip(row, widths))
+              .rstrip())
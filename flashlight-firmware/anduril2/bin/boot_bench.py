@@ -0,0 +1,179 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from anduril_build import ANDURIL_DIR, build_sim, build_sim_targets, \
+    extract_revision, io_registers, parse_args, print_table, sim_targets, \
+    value
+
+# when to press the button for --wake, in seconds after power-on
+WAKE_PRESS_SECONDS = 1.5
+
+
+def main(args):
+    """Measures time from power-on to first light for each Anduril build,
+    by running it in simavr (with bin/fsm-sim.c).
+
+    Usage: boot_bench.py [options] [pattern]
+    Options:
+      --wake             also measure button-to-light latency from standby
+                         (presses the button after the light goes to sleep)
+      --memorized        build with START_AT_MEMORIZED_LEVEL (dual switch)
+      --eeprom FILE      start with this raw EEPROM dump (from avrdude),
+                         instead of blank EEPROM (first boot after flashing)
+      --baseline REV     also measure git revision REV, flag regressions
+      --threshold PCT    regression threshold, in percent (default 5)
+      --csv              print CSV instead of a table
+
+    "Light" is the first nonzero write to any of the cfg's PWMn_LVL
+    registers.  With --wake, the comparison uses wake latency.  Needs
+    avr-gcc (builds the targets out of tree, with the Makefile), simavr,
+    and libelf.  The attiny1616 family isn't supported by simavr, so
+    those targets are skipped.
+
+    Exits with status 1 if --baseline finds a regression.
+    """
+    opts = parse_args(args, {
+        '--wake': ('wake', None, False),
+        '--memorized': ('memorized', None, False),
+        '--eeprom': ('eeprom', os.path.abspath, None),
+        '--baseline': ('baseline', str, None),
+        '--threshold': ('threshold', float, 5.0),
+        '--csv': ('csv', None, False),
+        }, main.__doc__)
+    if opts is None:
+        return 2
+    flags = []
+    if opts['memorized']:
+        flags.append('-DSTART_AT_MEMORIZED_LEVEL')
+
+    tmp = tempfile.mkdtemp()
+    try:
+        sim = build_sim(tmp)
+        if not sim:
+            return 2
+        options = {'flags': flags, 'eeprom': opts['eeprom'], 'sim': sim,
+                   'tmp': tmp, 'wake': opts['wake']}
+        results = bench_tree(ANDURIL_DIR, opts['pattern'], options)
+        old = None
+        if opts['baseline']:
+            old_tmp = tempfile.mkdtemp(dir=tmp)
+            old_dir = extract_revision(ANDURIL_DIR, opts['baseline'],
+                                       old_tmp)
+            old = bench_tree(old_dir, opts['pattern'], options)
+    finally:
+        shutil.rmtree(tmp)
+
+    regressions = report(results, old, opts['threshold'], opts['csv'],
+                         opts['wake'])
+    if regressions:
+        return 1
+    return 0
+
+
+def bench_tree(anduril_dir, pattern, options):
+    """Returns {target: result} for every matching cfg file."""
+    targets = sim_targets(anduril_dir, pattern)
+    # each tree gets its own build directory
+    build_sim_targets(anduril_dir, targets,
+                      tempfile.mkdtemp(dir=options['tmp']), options['flags'])
+    results = {}
+    for name in sorted(targets):
+        t = targets[name]
+        if 'error' in t:
+            results[name] = t
+        else:
+            results[name] = bench_target(t['elf'], t['mcu'], t['macros'],
+                                         options)
+    return results
+
+
+def bench_target(elf, mcu, macros, options):
+    result = {'mcu': mcu}
+
+    registers = io_registers(mcu)
+    cmd = [options['sim'], '-m', 'attiny%i' % mcu]
+    f_cpu = value(macros, 'F_CPU', 8000000)
+    cmd += ['-f', str(f_cpu)]
+    for n in range(1, 5):
+        reg = macros.get('PWM%i_LVL' % n)
+        if reg not in registers:
+            continue
+        addr, size = registers[reg]
+        for a in range(addr, addr + size):
+            cmd += ['-w', str(a)]
+    switch = re.match(r'^P([A-Z])(\d)$', macros.get('SWITCH_PIN', ''))
+    if switch:
+        cmd += ['-s', '%s:%s' % switch.groups()]
+    if options['eeprom']:
+        cmd += ['-e', options['eeprom']]
+    if options['wake']:
+        # the off state goes to standby about half a second after boot
+        cmd += ['-p', str(WAKE_PRESS_SECONDS)]
+    cmd.append(elf)
+
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE)
+    out, err = proc.communicate()
+    if proc.returncode:
+        result['error'] = err.decode().strip() or 'simulator failed'
+        return result
+    found = dict(line.split() for line in out.decode().splitlines())
+    if found.get('first_light', 'none') == 'none':
+        result['error'] = 'no light'
+        return result
+    result['cycles'] = int(found['first_light'])
+    result['ms'] = result['cycles'] * 1000.0 / f_cpu
+    if options['wake']:
+        if found.get('press_to_light', 'none') == 'none':
+            result['error'] = 'no light after press'
+            return result
+        result['wake_cycles'] = int(found['press_to_light'])
+        result['wake_ms'] = result['wake_cycles'] * 1000.0 / f_cpu
+    return result
+
+
+def report(results, old, threshold, csv, wake):
+    """Prints the results, returns the number of regressions."""
+    columns = ('target', 'mcu', 'boot cycles', 'boot ms')
+    if wake:
+        columns += ('wake cycles', 'wake ms')
+    # compare wake latency when it's measured, otherwise boot time
+    key = 'wake_ms' if wake else 'ms'
+    if old is not None:
+        columns += ('was ms', 'flag')
+    rows = []
+    regressions = 0
+    for name in sorted(results):
+        r = results[name]
+        if 'error' in r:
+            rows.append([name, str(r['mcu']), '-', r['error']])
+            continue
+        row = [name, str(r['mcu']), str(r['cycles']), '%.2f' % r['ms']]
+        if wake:
+            row += [str(r['wake_cycles']), '%.2f' % r['wake_ms']]
+        if old is not None:
+            o = old.get(name)
+            if not o or 'error' in o:
+                row += ['-', 'new']
+            else:
+                flag = ''
+                if r[key] > o[key] * (1.0 + threshold / 100.0):
+                    flag = 'REGRESSION'
+                    regressions += 1
+                row += ['%.2f' % o[key], flag]
+        rows.append(row)
+
+    print_table(columns, rows, csv)
+    return regressions
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
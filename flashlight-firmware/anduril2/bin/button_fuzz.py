@@ -0,0 +1,118 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from anduril_build import make_stubs
+
+
+def main(args):
+    """Fuzzes the FSM's button event decoder (push_event(), PCINT_inner(),
+    WDT_inner(), and waking from standby) on the host, with bin/fsm-fuzz.c.
+
+    Usage: button_fuzz.py [options] [corpus_dir]
+    Options:
+      --seconds N      stop after this long (default 60, 0 = forever)
+      --jobs N         fuzzing processes at once (default 1)
+      --standalone     no libFuzzer: build with cc, run random inputs
+      --runs N         with --standalone, how many (default 1000000)
+      --repro FILE     run one input (like a crash file) and stop
+
+    With clang, this uses libFuzzer, with address and undefined behavior
+    sanitizers, and keeps interesting inputs in corpus_dir (default:
+    fuzz-corpus) so later runs pick up where earlier ones stopped.  Crash
+    inputs are saved as crash-* in the current directory.  The checks
+    are described at the top of fsm-fuzz.c.  "make check" in the anduril
+    directory runs it with --standalone.
+
+    Exits with status 1 if any check fails.
+    """
+    corpus = 'fuzz-corpus'
+    seconds = 60
+    jobs = 1
+    standalone = False
+    runs = 1000000
+    repro = None
+
+    i = 0
+    while i < len(args):
+        a = args[i]
+        if a == '--seconds':
+            i += 1
+            seconds = int(args[i])
+        elif a == '--jobs':
+            i += 1
+            jobs = int(args[i])
+        elif a == '--standalone':
+            standalone = True
+        elif a == '--runs':
+            i += 1
+            runs = int(args[i])
+        elif a == '--repro':
+            i += 1
+            repro = os.path.abspath(args[i])
+        elif a.startswith('-'):
+            print(main.__doc__)
+            return 2
+        else:
+            corpus = a
+        i += 1
+
+    here = os.path.dirname(os.path.abspath(__file__))
+    fsm_dir = os.path.join(here, '..', 'ToyKeeper', 'spaghetti-monster')
+    tmp = tempfile.mkdtemp()
+    stubs = make_stubs()
+    try:
+        fuzzer = build(here, fsm_dir, stubs, tmp, standalone)
+        if not fuzzer:
+            return 2
+        if repro:
+            cmd = [fuzzer, repro]
+        elif standalone:
+            cmd = [fuzzer, '-n', str(runs)]
+        else:
+            if not os.path.isdir(corpus):
+                os.makedirs(corpus)
+            cmd = [fuzzer, corpus, '-max_total_time=%i' % seconds,
+                   '-print_final_stats=1']
+            if jobs > 1:
+                cmd.append('-fork=%i' % jobs)
+        status = subprocess.call(cmd)
+    finally:
+        shutil.rmtree(stubs)
+        shutil.rmtree(tmp)
+    return 1 if status else 0
+
+
+def build(here, fsm_dir, stubs, tmp, standalone):
+    """Compiles fsm-fuzz.c, returns the program's path."""
+    out = os.path.join(tmp, 'fsm-fuzz')
+    flags = ['-g', '-std=gnu99', '-fgnu89-inline',
+             '-I%s' % stubs, '-I%s' % fsm_dir,
+             '-o', out, os.path.join(here, 'fsm-fuzz.c')]
+    if standalone:
+        cmd = ['cc', '-O2', '-DFUZZ_STANDALONE'] + flags
+    else:
+        cmd = ['clang', '-O1',
+               '-fsanitize=fuzzer,address,undefined'] + flags
+    try:
+        status = subprocess.call(cmd)
+    except OSError:
+        status = 1
+    if status:
+        if standalone:
+            print('can\'t build fsm-fuzz')
+        else:
+            print('can\'t build fsm-fuzz with libFuzzer '
+                  '(needs clang, or try --standalone)')
+        return None
+    return out
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,86 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import os
+import re
+
+
+def main(args):
+    """Estimates battery current per ramp level, from a config file's
+    PWM tables plus the full-power current of each channel.
+
+    Usage: current_calc.py cfg-file.h TYPE:mA [TYPE:mA ...]
+      (one TYPE:mA per PWM channel, in order, TYPE is 7135 or FET)
+    Example: current_calc.py cfg-emisar-d4v2.h 7135:350 FET:13000
+
+    Prints a BATT_MA_LEVELS line to paste into the config file.
+    """
+    if len(args) < 2:
+        print(main.__doc__)
+        return
+
+    cfg = read_cfg(args[0])
+    channels = []
+    for arg in args[1:]:
+        typ, ma = arg.split(':')
+        channels.append((typ.upper(), float(ma)))
+
+    tables = []
+    for i in range(len(channels)):
+        tables.append(get_list(cfg, 'PWM%i_LEVELS' % (i+1)))
+    num_levels = len(tables[0])
+    tops = get_list(cfg, 'PWM_TOPS')
+    if not tops:
+        tops = [255] * num_levels
+
+    levels = []
+    for l in range(num_levels):
+        linear = 0.0
+        fet = None
+        for (typ, ma), table in zip(channels, tables):
+            duty = float(table[l]) / tops[l]
+            if duty > 1.0: duty = 1.0
+            if typ == 'FET':
+                fet = (duty, ma)
+            else:
+                linear += duty * ma
+        # a FET shorts the LEDs to the battery while it's on,
+        # so the linear channels only matter during the FET's off time
+        if fet:
+            duty, ma = fet
+            current = (duty * ma) + ((1.0 - duty) * linear)
+        else:
+            current = linear
+        levels.append(int(round(current)))
+
+    print('// ../../../bin/current_calc.py %s' % (' '.join(args)))
+    print('#define BATT_MA_LEVELS %s' % (','.join([str(x) for x in levels])))
+
+
+def read_cfg(path):
+    """Reads a config file, with any included config files inlined."""
+    lines = []
+    for line in open(path):
+        inc = re.match(r'^#include\s+"(cfg-.*\.h)"', line)
+        if inc:
+            lines.append(read_cfg(os.path.join(os.path.dirname(path),
+                                               inc.group(1))))
+        else:
+            lines.append(line)
+    return ''.join(lines)
+
+
+def get_list(text, name):
+    """Finds the last "#define NAME 1,2,3..." (not commented out)
+    in a config file, since later definitions override earlier ones."""
+    found = re.findall(r'^#define\s+%s\s+([0-9, ]+)$' % (name,),
+                       text, re.MULTILINE)
+    if not found:
+        return []
+    return [int(x) for x in found[-1].split(',')]
+
+
+if __name__ == "__main__":
+    import sys
+    main(sys.argv[1:])
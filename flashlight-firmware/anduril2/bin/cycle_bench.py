@@ -0,0 +1,249 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from anduril_build import ANDURIL_DIR, build_sim, build_sim_targets, \
+    data_symbol, extract_revision, function_addresses, parse_args, \
+    print_table, sim_targets, value, vector_names
+
+# functions to time, when they exist as real functions in the ELF
+# (ISRs are found by vector name, so they work on every MCU)
+DEFAULT_FUNCTIONS = (
+    'WDT_vect', 'ADC_vect', 'PCINT0_vect', 'PCINT_vect',
+    'handle_deferred_interrupts', 'WDT_inner', 'adc_deferred',
+    'process_emissions', 'emit_now', 'set_level', 'update_tint',
+    'gradual_tick', 'clock_update', 'rgb_led_update', 'button_led_update',
+)
+
+# what the simulated user does, in seconds after power-on:
+# click on, hold to ramp up, click off, then leave it in standby
+BUTTON_TIMES = (1.0, 1.15, 2.0, 3.5, 4.5, 4.6)
+STANDBY_FROM = 6.0
+RUN_SECONDS = 14.0
+
+
+def main(args):
+    """Times Anduril's hot paths, cycle by cycle, for each build target,
+    by running the real firmware in simavr (with bin/fsm-sim.c).
+
+    Usage: cycle_bench.py [options] [pattern]
+    Options:
+      --func NAME        also time this function (repeatable)
+      --volts V          battery voltage (default 3.7)
+      --adc CH:MV        also drive ADC channel CH (for voltage dividers)
+      --baseline REV     also measure git revision REV, flag regressions
+      --threshold PCT    regression threshold, in percent (default 5)
+      --cycles FILE      write "target,cycles" per sleep tick, for
+                         standby_calc.py --cycles
+      --csv              print CSV instead of a table
+      --vcd DIR          build with USE_PROBES, write DIR/<target>.vcd,
+                         and report each probe's total active time
+
+    Each target boots, gets clicked on, ramped up, clicked off, and then
+    sits in standby.  For each function it reports how many times it ran,
+    and min / avg / max cycles per call (including any interrupts which
+    hit in the middle).  Functions which the compiler inlined can't be
+    timed this way, and show as "inlined".  Standby shows as "sleep tick":
+    the average cycles awake per wake-up.
+
+    With --vcd, the FSM probes (fsm-probe.h) show when each ISR and hot
+    path runs, and when the MCU sleeps, for a VCD viewer like GTKWave.
+    Each one is also reported as "probe:NAME", with how many times it
+    started and its average cycles per start.  (Probes add a few cycles
+    each, so the other timings come out a little higher than usual.)
+
+    With --baseline, a function whose average or max got more than
+    --threshold percent slower is a regression.  Exits with status 1 if
+    there are any.  Needs avr-gcc, simavr, and libelf.  The attiny1616
+    family isn't supported by simavr, so those targets are skipped.
+    """
+    opts = parse_args(args, {
+        '--func': ('functions', str, []),
+        '--volts': ('volts', float, 3.7),
+        '--adc': ('adc', str, None),
+        '--baseline': ('baseline', str, None),
+        '--threshold': ('threshold', float, 5.0),
+        '--cycles': ('cycles', str, None),
+        '--csv': ('csv', None, False),
+        '--vcd': ('vcd', os.path.abspath, None),
+        }, main.__doc__)
+    if opts is None:
+        return 2
+    vcd = opts['vcd']
+
+    tmp = tempfile.mkdtemp()
+    try:
+        sim = build_sim(tmp)
+        if not sim:
+            return 2
+        options = {'flags': [], 'sim': sim, 'tmp': tmp,
+                   'functions': list(DEFAULT_FUNCTIONS) + opts['functions'],
+                   'volts': opts['volts'], 'adc': opts['adc'], 'vcd': vcd}
+        if vcd:
+            options['flags'].append('-DUSE_PROBES')
+            if not os.path.isdir(vcd):
+                os.makedirs(vcd)
+        results = bench_tree(ANDURIL_DIR, opts['pattern'], options)
+        old = None
+        if opts['baseline']:
+            old_tmp = tempfile.mkdtemp(dir=tmp)
+            old_dir = extract_revision(ANDURIL_DIR, opts['baseline'],
+                                       old_tmp)
+            old = bench_tree(old_dir, opts['pattern'], options)
+    finally:
+        shutil.rmtree(tmp)
+
+    if opts['cycles']:
+        with open(opts['cycles'], 'w') as fp:
+            for name in sorted(results):
+                tick = results[name].get('funcs', {}).get('sleep tick')
+                if tick:
+                    fp.write('%s,%i\n' % (name, tick['avg']))
+
+    regressions = report(results, old, opts['threshold'], opts['csv'])
+    if regressions:
+        return 1
+    return 0
+
+
+def bench_tree(anduril_dir, pattern, options):
+    """Returns {target: result} for every matching cfg file."""
+    targets = sim_targets(anduril_dir, pattern)
+    # each tree gets its own build directory
+    build_sim_targets(anduril_dir, targets,
+                      tempfile.mkdtemp(dir=options['tmp']), options['flags'])
+    results = {}
+    for name in sorted(targets):
+        t = targets[name]
+        if 'error' in t:
+            results[name] = t
+        else:
+            results[name] = bench_target(t['elf'], name, t['mcu'],
+                                         t['macros'], options)
+    return results
+
+
+def bench_target(elf, name, mcu, macros, options):
+    result = {'mcu': mcu}
+    switch = re.match(r'^P([A-Z])(\d)$', macros.get('SWITCH_PIN', ''))
+    if not switch:
+        result['error'] = 'no switch pin'
+        return result
+
+    symbols = function_addresses(elf)
+    vectors = vector_names(mcu)
+    cmd = [options['sim'], '-m', 'attiny%i' % mcu,
+           '-f', str(value(macros, 'F_CPU', 8000000)),
+           '-s', '%s:%s' % switch.groups(),
+           '-b', ','.join(str(t) for t in BUTTON_TIMES),
+           '-v', str(int(options['volts'] * 1000)),
+           '-S', str(STANDBY_FROM), '-t', str(RUN_SECONDS)]
+    if options['adc']:
+        cmd += ['-a', options['adc']]
+    if options['vcd']:
+        trace = data_symbol(elf, 'probe_trace')
+        if trace:
+            addr, size = trace
+            cmd += ['-P', '%i:%i' % (addr, size - 1),
+                    '-V', os.path.join(options['vcd'], name + '.vcd')]
+    timed = []
+    for f in options['functions']:
+        sym = vectors.get(f, f)
+        if sym in symbols:
+            cmd += ['-F', '%s=%i' % (f, symbols[sym])]
+            timed.append(f)
+    cmd.append(elf)
+
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE)
+    out, err = proc.communicate()
+    if proc.returncode:
+        result['error'] = err.decode().strip() or 'simulator failed'
+        return result
+
+    funcs = {}
+    wakes = awake = 0
+    for line in out.decode().splitlines():
+        parts = line.split()
+        if not parts:
+            continue
+        if parts[0] == 'func':
+            stats = dict(zip(parts[2::2], (int(x) for x in parts[3::2])))
+            if stats.get('calls'):
+                funcs[parts[1]] = stats
+        elif parts[0] == 'probe':
+            count, cycles = int(parts[3]), int(parts[5])
+            if count:
+                funcs['probe:' + parts[1]] = {'calls': count, 'min': 0,
+                                              'avg': cycles // count,
+                                              'max': 0}
+        elif parts[0] == 'standby_wakes':
+            wakes = int(parts[1])
+        elif parts[0] == 'standby_awake_cycles':
+            awake = int(parts[1])
+    if wakes:
+        funcs['sleep tick'] = {'calls': wakes, 'min': 0,
+                               'avg': awake // wakes, 'max': 0}
+    # functions which never ran, or were inlined
+    # (ISRs this MCU doesn't have, or doesn't use, are left out)
+    for f in options['functions']:
+        if f in funcs:
+            continue
+        if f in timed:
+            funcs[f] = {'calls': 0}
+        elif not f.endswith('_vect'):
+            funcs[f] = None
+    result['funcs'] = funcs
+    return result
+
+
+def report(results, old, threshold, csv):
+    """Prints the results, returns the number of regressions."""
+    columns = ['target', 'mcu', 'function', 'calls', 'min', 'avg', 'max']
+    if old is not None:
+        columns += ['was avg', 'was max', 'flag']
+    rows = []
+    regressions = 0
+    for name in sorted(results):
+        r = results[name]
+        if 'error' in r:
+            rows.append([name, str(r['mcu']), '-', r['error']])
+            continue
+        for f in sorted(r['funcs']):
+            stats = r['funcs'][f]
+            if stats is None:
+                rows.append([name, str(r['mcu']), f, 'inlined'])
+                continue
+            if not stats.get('calls'):
+                rows.append([name, str(r['mcu']), f, '0'])
+                continue
+            row = [name, str(r['mcu']), f, str(stats['calls'])] + [
+                str(stats[k]) if stats[k] else '-'
+                for k in ('min', 'avg', 'max')]
+            if old is not None:
+                o = old.get(name, {}).get('funcs', {}).get(f)
+                if not o or not o.get('calls'):
+                    row += ['-', '-', 'new']
+                else:
+                    flag = ''
+                    limit = 1.0 + threshold / 100.0
+                    if (stats['avg'] > o['avg'] * limit) or \
+                       (o['max'] and stats['max'] > o['max'] * limit):
+                        flag = 'REGRESSION'
+                        regressions += 1
+                    row += [str(o['avg']), str(o['max'] or '-'), flag]
+            rows.append(row)
+
+    print_table(columns, rows, csv)
+    return regressions
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
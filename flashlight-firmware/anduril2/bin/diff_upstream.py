@@ -0,0 +1,354 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from fnmatch import fnmatchcase
+from multiprocessing import cpu_count
+from multiprocessing.pool import ThreadPool
+
+from anduril_build import ANDURIL_DIR, HERE, build_sim, build_sim_targets, \
+    data_symbol, function_addresses, parse_args, print_table, section_sizes
+from ui_trace import SCENARIOS, SLACK_MS, compare, find_targets, \
+    name_trace, read_script
+
+
+def main(args):
+    """Compares this fork's Anduril against the open source Anduril it's
+    based on, target by target: what the UI does, and how big and how
+    busy the firmware is.
+
+    Usage: diff_upstream.py [options] [pattern]
+    Options:
+      --upstream DIR     the open source anduril directory (default:
+                         open_source_code/anduril2/... in this repo)
+      --scenario NAME    only this built-in input script (repeatable)
+      --script FILE      also run this input script (repeatable)
+      --volts V          battery voltage (default 3.7)
+      --slack MS         timing tolerance (default 20)
+      --expected FILE    the fork's intended UI changes (default:
+                         diff_upstream_expected.txt, next to this script)
+      --accept           add every unexpected change to FILE
+      --diff             show what the UI does differently
+      --jobs N           builds / simulations at once (default: CPUs)
+      --csv              print CSV instead of a table
+
+    Each target which is in both trees gets built from both, then both
+    builds run the same input scripts in simavr (like ui_trace.py, but
+    watching current_state for state changes, since the open source code
+    has no event trace).  The UI "differs" if the button presses lead to
+    different states or light levels, in a different order, or more than
+    --slack ms apart.
+
+    Sizes are flash (text + data) and RAM (data + bss).  Cycles are the
+    time to first light after power-on, and the total cycles awake over
+    every input script.  The change columns are fork minus upstream.
+
+    The fork's intended UI changes are listed in the expected file, one
+    per line, as "<target> <script> <change>", where target and script
+    can be shell-style patterns like * and change is one changed line of
+    a --diff: a state or light line with - (only upstream does it) or +
+    (only the fork does it) in front, or with ~ in front if only its time
+    moved.  For example:
+      emisar-d4v2  *  +state lockout_state
+      *  ramp  ~light PWM1_LVL 150
+    A target's UI differs only if a change isn't in the file ("expected"
+    otherwise).  Entries which match nothing any more, on a target and
+    script which ran, are reported as stale, so they can be removed.
+
+    Exits with status 1 if the UI differs unexpectedly on any target, so
+    after moving to a new upstream revision, only real surprises show
+    up.  Needs avr-gcc, simavr, and libelf.  The attiny1616 family isn't
+    supported by simavr, so those targets are skipped.
+    """
+    opts = parse_args(args, {
+        '--upstream': ('upstream', str, os.path.join(
+            HERE, '..', '..', '..', 'open_source_code', 'anduril2',
+            'ToyKeeper', 'spaghetti-monster', 'anduril')),
+        '--scenario': ('only', str, []),
+        '--script': ('scripts', str, []),
+        '--volts': ('volts', float, 3.7),
+        '--slack': ('slack', float, SLACK_MS),
+        '--expected': ('expected', str, os.path.join(
+            HERE, 'diff_upstream_expected.txt')),
+        '--accept': ('accept', None, False),
+        '--diff': ('diff', None, False),
+        '--jobs': ('jobs', int, cpu_count()),
+        '--csv': ('csv', None, False),
+        }, main.__doc__)
+    if opts is None:
+        return 2
+    only = opts['only']
+    upstream_dir = opts['upstream']
+    jobs = opts['jobs']
+
+    scenarios = {}
+    for name, inputs, seconds in SCENARIOS:
+        if (not only) or (name in only):
+            scenarios[name] = (inputs, seconds)
+    for path in opts['scripts']:
+        name = os.path.splitext(os.path.basename(path))[0]
+        try:
+            scenarios[name] = read_script(path)
+        except ValueError as e:
+            print('%s: %s' % (path, e))
+            return 2
+    if not scenarios:
+        print('no such scenario: %s' % ', '.join(only))
+        return 2
+    if not os.path.isdir(upstream_dir):
+        print('no upstream tree at %s' % upstream_dir)
+        return 2
+    try:
+        expected = read_expected(opts['expected'])
+    except ValueError as e:
+        print('%s: %s' % (opts['expected'], e))
+        return 2
+
+    tmp = tempfile.mkdtemp()
+    try:
+        sim = build_sim(tmp)
+        if not sim:
+            return 2
+        dirs = {'fork': ANDURIL_DIR, 'upstream': upstream_dir}
+        trees = {'fork': find_targets(ANDURIL_DIR, opts['pattern']),
+                 'upstream': find_targets(upstream_dir, opts['pattern'])}
+        both = sorted(set(trees['fork']) & set(trees['upstream']))
+
+        # build every target which is in both trees, one tree at a time
+        # (the upstream tree gets built with this tree's Makefile)
+        for tree in sorted(trees):
+            targets = trees[tree]
+            build_sim_targets(dirs[tree],
+                              dict((n, targets[n]) for n in both),
+                              os.path.join(tmp, tree), jobs=jobs)
+            for name in both:
+                t = trees[tree][name]
+                if 'error' in t:
+                    continue
+                state = data_symbol(t['elf'], 'current_state')
+                if not state:
+                    t['error'] = 'no current_state in the build'
+                    continue
+                t['size'] = section_sizes(t['elf'])
+                t['state_addr'] = state[0]
+                t['states'] = dict((a, s) for s, a in
+                                   function_addresses(t['elf']).items())
+
+        # then run every script on both builds of each target
+        runs = []
+        for name in both:
+            if any('error' in trees[tree][name] for tree in trees):
+                continue
+            for script in sorted(scenarios):
+                inputs, seconds = scenarios[script]
+                for tree in sorted(trees):
+                    trace = os.path.join(tmp, '%s.%s.%s.trace'
+                                         % (tree, name, script))
+                    cmd = sim_command(sim, trees[tree][name], inputs,
+                                      seconds, opts['volts'], trace)
+                    runs.append((tree, name, script, seconds, (cmd, trace)))
+        pool = ThreadPool(jobs)
+        outputs = pool.map(run_sim, [run for _, _, _, _, run in runs])
+        pool.close()
+    finally:
+        shutil.rmtree(tmp)
+
+    # {(tree, name, script): (trace lines, first light, awake cycles)}
+    done = {}
+    errors = {}
+    for (tree, name, script, seconds, _), (status, out) in \
+            zip(runs, outputs):
+        if status:
+            errors[name] = '%s: %s' % (tree, out.strip() or 'sim failed')
+            continue
+        trace, results = out
+        done[(tree, name, script)] = (
+            name_trace(trace, trees[tree][name], seconds, False),
+            results.get('first_light'), results.get('standby_awake_cycles'))
+
+    rows = []
+    diffs = []
+    for name in sorted(set(trees['fork']) | set(trees['upstream'])):
+        row = compare_target(name, trees, scenarios, done, errors,
+                             opts['slack'], expected, diffs)
+        rows.append(row)
+    print_table(['target', 'mcu', 'flash', 'change', 'ram', 'change',
+                 'boot cycles', 'awake cycles', 'ui'], rows, opts['csv'])
+    if opts['diff']:
+        for name, script, diff, _ in diffs:
+            print()
+            print('%s %s:' % (name, script))
+            for line in diff[:40]:
+                print('  ' + line)
+            if len(diff) > 40:
+                print('  ... (%i more)' % (len(diff) - 40))
+
+    # only entries which could have matched something are stale
+    ran = set((name, script) for _, name, script in done)
+    stale = [e for e in expected if not e['used'] and any(
+        fnmatchcase(name, e['target']) and fnmatchcase(script, e['script'])
+        for name, script in ran)]
+    if stale:
+        print()
+        print('stale entries in %s:' % opts['expected'])
+        for e in stale:
+            print('  %i: %s' % (e['line'], e['text']))
+
+    unexpected = [(name, script, change)
+                  for name, script, _, changes in diffs
+                  for change in changes]
+    if unexpected and opts['accept']:
+        with open(opts['expected'], 'a') as fp:
+            for entry in unexpected:
+                fp.write('%s  %s  %s\n' % entry)
+        print()
+        print('added %i changes to %s' % (len(unexpected), opts['expected']))
+        return 0
+    if unexpected:
+        return 1
+    return 0
+
+
+def read_expected(path):
+    """Reads the expected changes file, returns a list of entries.
+    A missing file is the same as an empty one."""
+    entries = []
+    if not os.path.exists(path):
+        return entries
+    with open(path) as fp:
+        for n, line in enumerate(fp, 1):
+            text = line.split('#')[0].strip()
+            if not text:
+                continue
+            parts = text.split(None, 2)
+            if len(parts) != 3 or parts[2][0] not in '+-~':
+                raise ValueError('bad line %i: %s' % (n, line.strip()))
+            entries.append({'target': parts[0], 'script': parts[1],
+                            'change': ' '.join(parts[2].split()),
+                            'line': n, 'text': text, 'used': False})
+    return entries
+
+
+def diff_changes(diff):
+    """Returns each changed line of a compare() diff, in the form the
+    expected file uses: '+what', '-what', or '~what' for a time change."""
+    changes = []
+    for line in diff:
+        if line.startswith(('+++', '---', '@@', ' ')):
+            continue
+        if line[:1] in '+-':
+            changes.append(line)
+        elif ': was at ' in line:
+            changes.append('~' + line.split(': was at ', 1)[0])
+    return changes
+
+
+def unexpected_changes(name, script, diff, expected):
+    """Returns the changes in a diff which aren't in the expected file,
+    and marks the entries which matched as used."""
+    entries = [e for e in expected if fnmatchcase(name, e['target'])
+               and fnmatchcase(script, e['script'])]
+    unexpected = []
+    for change in diff_changes(diff):
+        change = ' '.join(change.split())
+        matched = [e for e in entries if e['change'] == change]
+        for e in matched:
+            e['used'] = True
+        if not matched:
+            unexpected.append(change)
+    return unexpected
+
+
+def sim_command(sim, t, inputs, seconds, volts, trace):
+    cmd = [sim, '-m', 'attiny%i' % t['mcu'], '-f', str(t['f_cpu']),
+           '-s', t['switch'], '-v', str(int(volts * 1000)),
+           '-C', str(t['state_addr']), '-T', trace,
+           '-S', '0.001', '-t', str(seconds)]
+    for addr in sorted(t['lights']):
+        cmd += ['-w', str(addr)]
+    if inputs:
+        cmd += ['-b', ','.join('%g' % when for when, _ in inputs)]
+    cmd.append(t['elf'])
+    return cmd
+
+
+def run_sim(run):
+    """Returns (exit status, (trace, {result: cycles}) or error message)."""
+    cmd, trace = run
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE)
+    out, err = proc.communicate()
+    if proc.returncode:
+        return proc.returncode, err.decode()
+    results = {}
+    for line in out.decode().splitlines():
+        parts = line.split()
+        if len(parts) == 2 and parts[1].isdigit():
+            results[parts[0]] = int(parts[1])
+    with open(trace) as fp:
+        return 0, (fp.read(), results)
+
+
+def compare_target(name, trees, scenarios, done, errors, slack, expected,
+                   diffs):
+    """Returns one report row for a target, and adds
+    (name, script, diff, unexpected changes) to diffs."""
+    fork = trees['fork'].get(name)
+    upstream = trees['upstream'].get(name)
+    mcu = str((fork or upstream)['mcu'])
+    if not upstream:
+        return [name, mcu, 'fork only']
+    if not fork:
+        return [name, mcu, 'upstream only']
+    for tree, t in (('fork', fork), ('upstream', upstream)):
+        if 'error' in t:
+            return [name, mcu, '%s: %s' % (tree, t['error'])]
+    if name in errors:
+        return [name, mcu, errors[name]]
+
+    flash = [t['size'][0] + t['size'][1] for t in (fork, upstream)]
+    ram = [t['size'][1] + t['size'][2] for t in (fork, upstream)]
+    boot = [None, None]
+    awake = [0, 0]
+    differ = []
+    intended = []
+    for script in sorted(scenarios):
+        runs = [done.get((tree, name, script))
+                for tree in ('fork', 'upstream')]
+        if None in runs:
+            continue
+        for n, (_, first_light, cycles) in enumerate(runs):
+            if first_light and boot[n] is None:
+                boot[n] = first_light
+            awake[n] += cycles or 0
+        diff = compare(runs[1][0], runs[0][0], slack,
+                       ('upstream', 'fork'))
+        if diff:
+            changes = unexpected_changes(name, script, diff, expected)
+            (differ if changes else intended).append(script)
+            diffs.append((name, script, diff, changes))
+
+    row = [name, mcu, str(flash[0]), '%+i' % (flash[0] - flash[1]),
+           str(ram[0]), '%+i' % (ram[0] - ram[1])]
+    for fork_cycles, upstream_cycles in (boot, awake):
+        if fork_cycles and upstream_cycles:
+            row.append('%+.1f%%' % (100.0 * fork_cycles / upstream_cycles
+                                    - 100.0))
+        else:
+            row.append('-')
+    if differ:
+        row.append('differs: ' + ' '.join(differ))
+    elif intended:
+        row.append('expected: ' + ' '.join(intended))
+    else:
+        row.append('same')
+    return row
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,261 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+from multiprocessing import cpu_count
+from multiprocessing.pool import ThreadPool
+
+from anduril_build import ANDURIL_DIR, MCU_SIZES, build_targets, \
+    find_cfgs, make_stubs, parse_args, section_sizes
+
+# not worth trying without (the UI can't work without them)
+NOT_FEATURES = ('USE_RAMPING', 'USE_IDLE_MODE')
+
+
+def main(args):
+    """Measures how much flash and RAM each USE_* feature costs,
+    on each Anduril build target.
+
+    Usage: feature_cost.py [options] [pattern]
+    Options:
+      --features REGEX   only try features which match (like "LVP|THERM")
+      -j N               build N at once (default: number of CPUs)
+      --csv              print one CSV line per (feature, target)
+      --html FILE        also write a features x targets table as HTML
+
+    Builds each matching cfg-*.h once as-is, then once more for each
+    USE_* feature that its config turns on, with only that feature
+    turned off (via EXTRA_CONFIGFILE, after the target's config).
+
+    Without --csv, it prints a matrix of flash bytes saved by turning off
+    each feature (text + data), and the free flash / RAM per target.
+    "x" means the build fails without that feature (something else needs
+    it), "-" means the target doesn't use the feature, and "?" means the
+    target doesn't build at all (like attiny1616 without ATTINY_DFP).
+    In --csv output, the "(all)" line for each target has its section
+    sizes, and each feature line has the bytes saved, and the free flash
+    and RAM without that feature.
+    Each build goes through the Makefile, in a temp directory of its own.
+    Needs avr-gcc (and ATTINY_DFP for attiny1616 targets).
+    """
+    opts = parse_args(args, {
+        '--features': ('features', str, None),
+        '-j': ('jobs', int, cpu_count()),
+        '--csv': ('csv', None, False),
+        '--html': ('html', str, None),
+        }, main.__doc__)
+    if opts is None:
+        return 2
+
+    tmp = tempfile.mkdtemp()
+    stubs = make_stubs()
+    try:
+        targets = find_targets(ANDURIL_DIR, opts['pattern'], stubs,
+                               opts['features'])
+        builds = []
+        for name in sorted(targets):
+            mcu, features = targets[name]
+            builds.append((name, mcu, None))
+            for feature in features:
+                builds.append((name, mcu, feature))
+        pool = ThreadPool(opts['jobs'])
+        sizes = pool.map(lambda b: build(ANDURIL_DIR, tmp, *b), builds)
+        pool.close()
+    finally:
+        shutil.rmtree(stubs)
+        shutil.rmtree(tmp)
+
+    results = {}
+    for (name, mcu, feature), size in zip(builds, sizes):
+        results[(name, feature)] = size
+
+    if opts['csv']:
+        print_csv(targets, results)
+    else:
+        print_matrix(targets, results)
+    if opts['html']:
+        with open(opts['html'], 'w') as fp:
+            fp.write(html_matrix(targets, results))
+    return 0
+
+
+def find_targets(anduril_dir, pattern, stubs, feature_re):
+    """Returns {target: (mcu, [features its config turns on])}."""
+    targets = {}
+    for name, cfg, mcu in find_cfgs(anduril_dir, pattern):
+        features = config_features(anduril_dir, stubs, cfg, mcu)
+        if feature_re:
+            features = [f for f in features if re.search(feature_re, f)]
+        targets[name] = (mcu, features)
+    return targets
+
+
+def config_features(anduril_dir, stubs, cfg, mcu):
+    """Lists the USE_* flags which are on after the target's config,
+    but before the UI and FSM add their own requirements."""
+    src = os.path.join(stubs, 'config-only.c')
+    with open(src, 'w') as fp:
+        fp.write('#include "config-default.h"\n'
+                 '#include "tk.h"\n'
+                 '#include incfile(CONFIGFILE)\n')
+    cmd = ['cpp', '-dM', '-DATTINY=%i' % mcu, '-DCONFIGFILE=%s' % cfg,
+           '-DE2END=0x3ff', '-I.', '-I..', '-I../..', '-I../../..',
+           '-I%s' % stubs, src]
+    proc = subprocess.Popen(cmd, cwd=anduril_dir, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE)
+    out, _ = proc.communicate()
+    if proc.returncode:
+        return []
+    features = set()
+    for line in out.decode().splitlines():
+        m = re.match(r'^#define\s+(USE_\w+)\b', line)
+        if m and m.group(1) not in NOT_FEATURES:
+            features.add(m.group(1))
+    return sorted(features)
+
+
+def build(anduril_dir, tmp, name, mcu, feature):
+    """Builds one target, maybe without one feature.
+    Returns (text, data, bss), or None if it didn't build."""
+    # (a build directory of its own, so the builds can run at once)
+    work = tempfile.mkdtemp(dir=tmp)
+    flags = []
+    if feature:
+        with open(os.path.join(work, 'feature-off.h'), 'w') as fp:
+            fp.write('#undef %s\n' % feature)
+        flags = ['-I%s' % work, '-DEXTRA_CONFIGFILE=feature-off.h']
+    elf = build_targets(anduril_dir, [name], os.path.join(work, 'build'),
+                        flags, jobs=1)[name]
+    if not elf:
+        return None
+    return section_sizes(elf)
+
+
+def headroom(mcu, size):
+    """Returns (free flash, free RAM) in bytes."""
+    flash, ram = MCU_SIZES.get(mcu, (0, 0))
+    text, data, bss = size
+    return (flash - text - data, ram - data - bss)
+
+
+def delta(results, name, feature):
+    """Returns bytes saved by turning off a feature, as
+    (text, data, bss), or None if either build failed."""
+    base = results.get((name, None))
+    size = results.get((name, feature))
+    if not base or not size:
+        return None
+    return tuple(b - s for b, s in zip(base, size))
+
+
+def all_features(targets):
+    features = set()
+    for mcu, f in targets.values():
+        features.update(f)
+    return sorted(features)
+
+
+def print_csv(targets, results):
+    print('feature,target,mcu,text,data,bss,flash_free,ram_free')
+    for name in sorted(targets):
+        mcu, features = targets[name]
+        for feature in [None] + features:
+            size = results.get((name, feature))
+            label = feature or '(all)'
+            if not size:
+                print('%s,%s,%i,,,,,' % (label, name, mcu))
+                continue
+            free = headroom(mcu, size)
+            # the baseline row has sizes, feature rows have bytes saved
+            shown = size if feature is None else delta(results, name, feature)
+            if shown is None:
+                shown = ('', '', '')
+            print('%s,%s,%i,%s,%s,%s,%i,%i' % ((label, name, mcu) + tuple(
+                  str(x) for x in shown) + free))
+
+
+def cell(targets, results, name, feature):
+    """Text for one matrix cell: flash bytes saved, or x / -."""
+    if feature not in targets[name][1]:
+        return '-'
+    if not results.get((name, None)):
+        return '?'
+    d = delta(results, name, feature)
+    if d is None:
+        return 'x'
+    return str(d[0] + d[1])
+
+
+def print_matrix(targets, results):
+    names = sorted(targets)
+    rows = [['feature'] + names]
+    rows.append(['(mcu)'] + [str(targets[n][0]) for n in names])
+    for label, index in (('(flash free)', 0), ('(ram free)', 1)):
+        row = [label]
+        for n in names:
+            base = results.get((n, None))
+            row.append(str(headroom(targets[n][0], base)[index])
+                       if base else 'x')
+        rows.append(row)
+    for feature in all_features(targets):
+        rows.append([feature] + [cell(targets, results, n, feature)
+                                 for n in names])
+    widths = [max(len(row[i]) for row in rows) for i in range(len(rows[0]))]
+    for row in rows:
+        print('  '.join(c.rjust(w) if i else c.ljust(w)
+                        for i, (c, w) in enumerate(zip(row, widths))))
+
+
+def html_matrix(targets, results):
+    names = sorted(targets)
+    out = ['<!DOCTYPE html>', '<html><head><meta charset="utf-8">',
+           '<title>Anduril feature cost</title>',
+           '<style>td,th{padding:2px 6px;text-align:right}'
+           'th{position:sticky;top:0;background:#eee}'
+           'td.f{text-align:left}td.x{background:#fcc}'
+           'td.h{font-weight:bold}</style>',
+           '</head><body>',
+           '<p>Flash bytes saved by turning off each feature (text + data),'
+           ' per target.  Hover for text / data / bss.  '
+           '<b>x</b>: build fails without it.  '
+           '<b>-</b>: not used.  '
+           '<b>?</b>: target doesn\'t build.</p>',
+           '<table>',
+           '<tr><th>feature</th>' + ''.join(
+               '<th>%s<br>%i</th>' % (n, targets[n][0]) for n in names)
+           + '</tr>']
+    for label, index in (('flash free', 0), ('RAM free', 1)):
+        row = ['<tr><td class="f h">%s</td>' % label]
+        for n in names:
+            base = results.get((n, None))
+            if base:
+                row.append('<td class="h">%i</td>'
+                           % headroom(targets[n][0], base)[index])
+            else:
+                row.append('<td class="x">x</td>')
+        out.append(''.join(row) + '</tr>')
+    for feature in all_features(targets):
+        row = ['<tr><td class="f">%s</td>' % feature]
+        for n in names:
+            text = cell(targets, results, n, feature)
+            d = delta(results, n, feature)
+            if d:
+                row.append('<td title="text %i, data %i, bss %i">%s</td>'
+                           % (d + (text,)))
+            elif text in ('x', '?'):
+                row.append('<td class="x">%s</td>' % text)
+            else:
+                row.append('<td>%s</td>' % text)
+        out.append(''.join(row) + '</tr>')
+    out += ['</table>', '</body></html>', '']
+    return '\n'.join(out)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -5,5 +5,8 @@
 #           or 0xE2 for 64ms (useful on a twisty light)
 # Use high fuse 0xDE for BOD 1.8V,
 #            or 0xDF for no BOD
+# (but BOD only runs if the extended fuse enables it:
+#  0xFF = off, 0xFD = on while awake but off while asleep,
+#  0xED = on while awake and sampled while asleep ... see hwdef-Noctigon_KR4.h)
 avrdude -c usbasp -p t1634 -u -U lfuse:w:0xe2:m -U hfuse:w:0xde:m -U efuse:w:0xff:m
 
@@ -0,0 +1,400 @@
+/*
+ * fsm-fuzz.c: Fuzzes SpaghettiMonster's button event decoder on the host.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Build, with clang's libFuzzer (button_fuzz.py does this):
+ *   clang -g -O1 -fsanitize=fuzzer,address,undefined -std=gnu99 \
+ *     -fgnu89-inline -I STUBS -I ../ToyKeeper/spaghetti-monster \
+ *     -o fsm-fuzz fsm-fuzz.c
+ * where STUBS is a directory of empty AVR headers (avr/io.h, etc).
+ * Or with any compiler, add -DFUZZ_STANDALONE to get a plain program:
+ *   fsm-fuzz [-n RUNS] [-s SEED] [file ...]
+ * which runs RUNS random inputs, or replays the given files (like crash
+ * files from libFuzzer).
+ *
+ * This runs the real button code, push_event(), PCINT_inner(), the
+ * PCINT and WDT interrupts, WDT_inner(), and standby_mode() (with
+ * USE_FAST_WAKE), one clock tick at a time, with the switch pin driven
+ * by the fuzzer and a UI state which does what real UIs do partway
+ * through a button sequence: empty_event_sequence() during a hold,
+ * set_state() after a sequence, push_state() / pop_state() around a
+ * press, and going to standby.
+ *
+ * Every pin change runs the PCINT interrupt, while it's on.  In
+ * standby, each step is one wake-up: a press wakes it through PCINT,
+ * and a step without a change, but with ticks, is one sleep tick.  A
+ * press with 0 ticks is a bounce which is over before the fast-wake
+ * check reads the pin, and one with 1 tick lands on a sleep tick.
+ *
+ * Input bytes:
+ *   0      UI_* actions to use (low bits), and how many hold ticks
+ *          before UI_EMPTY_ON_HOLD acts (high 4 bits)
+ *   1, 2   ticks_since_last_event at the start, little-endian
+ *          (to reach its rollover without running 32768 ticks)
+ *   3      FUZZ_* options
+ *   4...   one per step: bit 0 is the switch (1 = pressed), and bits
+ *          1-7 are how many ticks it stays that way (0 is a bounce too
+ *          short for the clock to see)
+ *
+ * Checks, after every tick:
+ *   - the event queue never overflows
+ *   - push_state() never runs out of room
+ *   - ticks_since_last_event never rolls back below 0x8000
+ *   - each press counts one more click, up to 15, and holds and
+ *     releases keep the count of the press before them
+ *   - holds only happen while pressed
+ *   - standby only starts after the switch is let go
+ * and at the end, after letting go and waiting:
+ *   - every press got a release or timeout, and the sequence finished
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// host stand-ins for the parts of the MCU the button code touches
+#define ATTINY 85
+uint8_t SREG, GIMSK, MCUSR, WDTCR;
+#define PCIE 5
+#define WDIE 6
+#define WDCE 4
+#define WDE 3
+#define WDRF 3
+#define cli()
+#define sei()
+#define wdt_reset()
+#define _delay_loop_2(n)
+#define BOGOMIPS 1
+#define ISR(vector) void vector(void)
+// sleeping waits for the next input step
+static void fuzz_sleep(void);
+#define set_sleep_mode(mode)
+#define sleep_enable()
+#define sleep_disable()
+#define sleep_cpu() fuzz_sleep()
+// the switch's PIN register (high = not pressed)
+static uint8_t fuzz_pins = 0xff;
+#define SWITCH_PORT fuzz_pins
+#define SWITCH_PIN 0
+
+// the FSM features which change how buttons are handled
+#define DONT_USE_DEFAULT_STATE
+#define TICK_DURING_STANDBY
+#define USE_FAST_WAKE
+#define USE_PERF_COUNTERS  // for perf.dropped
+
+#include "fsm-probe.h"
+#include "fsm-events.h"
+#include "fsm-states.h"
+#include "fsm-adc.h"
+#include "fsm-wdt.h"
+#include "fsm-pcint.h"
+#include "fsm-standby.h"
+#include "fsm-perf.h"
+#include "fsm-telemetry.h"
+#include "fsm-main.h"
+
+// (standby turns the ADC off and on, but there isn't one here)
+uint8_t adc_reset;
+inline void ADC_on() {}
+inline void ADC_off() {}
+
+#include "fsm-states.c"
+#include "fsm-events.c"
+#include "fsm-wdt.c"
+#include "fsm-pcint.c"
+#include "fsm-standby.c"
+
+#define CHECK(cond, msg) do { if (! (cond)) fail(msg); } while (0)
+
+static void fail(const char *msg) {
+    fprintf(stderr, "fsm-fuzz: %s (current_event 0x%02x, "
+            "ticks_since_last_event %u, state_stack_len %u)\n",
+            msg, current_event, ticks_since_last_event, state_stack_len);
+    abort();
+}
+
+// UI actions, from the first input byte
+#define UI_EMPTY_ON_HOLD  1  // empty_event_sequence() partway into a hold
+#define UI_SET_STATE      2  // set_state() after each finished sequence
+#define UI_MOMENTARY      4  // push_state() on press, pop_state() on release
+#define UI_STANDBY        8  // go to standby after each finished sequence
+static uint8_t ui_actions;
+static uint8_t hold_limit;
+
+// other options, from the fourth input byte
+#define FUZZ_PCINT_INNER  1  // PCINT_inner() on every pin change, like the
+                             // PCINT interrupt did before the WDT took over
+static uint8_t fuzz_options;
+
+// input steps which haven't run yet
+static const uint8_t *steps;
+static size_t steps_left;
+
+// what the decoder has said so far
+static uint8_t press_open;  // a press event came, but no release yet
+static uint8_t last_count;  // click count of the last button event
+
+static uint8_t fuzz_state(Event event, uint16_t arg) {
+    if (! (event & B_CLICK)) return EVENT_HANDLED;  // not a button event
+    uint8_t count = event & B_COUNT;
+
+    if ((event & B_PRESS) && (! (event & B_HOLD))) {
+        uint8_t expected = (last_count < B_COUNT) ? last_count + 1 : B_COUNT;
+        CHECK(count == expected, "press didn't count one more click");
+        CHECK(! (event & B_TIMEOUT), "press event with a timeout");
+        last_count = count;
+        press_open = 1;
+        if (ui_actions & UI_MOMENTARY)
+            CHECK(push_state(fuzz_state, 0) >= 0, "state stack overflow");
+    }
+    else if (event & B_PRESS) {  // hold
+        CHECK(press_open, "hold without a press");
+        CHECK(count == last_count, "hold changed the click count");
+        if ((ui_actions & UI_EMPTY_ON_HOLD) && (arg >= hold_limit)) {
+            empty_event_sequence();
+            last_count = 0;
+        }
+    }
+    else {  // release, or a timeout after one
+        if (! (event & B_TIMEOUT)) {
+            CHECK(press_open, "release without a press");
+            CHECK(count == last_count, "release changed the click count");
+        }
+        if (press_open && (ui_actions & UI_MOMENTARY)
+                && (state_stack_len > 1))
+            pop_state();
+        press_open = 0;
+    }
+
+    // a timeout ends the sequence (WDT_inner() empties it this tick)
+    if (event & B_TIMEOUT) {
+        last_count = 0;
+        if (ui_actions & UI_SET_STATE)
+            CHECK(set_state(fuzz_state, 0) >= 0, "state stack overflow");
+        if (ui_actions & UI_STANDBY) go_to_standby = 1;
+    }
+    return EVENT_HANDLED;
+}
+
+// put every FSM global back the way it is at power-on
+static void fsm_reset(void) {
+    current_event = EV_none;
+    ticks_since_last_event = 0;
+    memset(emissions, 0, sizeof(emissions));
+    memset(state_stack, 0, sizeof(state_stack));
+    state_stack_len = 0;
+    current_state = NULL;
+    button_last_state = 0;
+    go_to_standby = 0;
+    nice_delay_interrupt = 0;
+    irq_pending_bits = 0;
+    memset(&perf, 0, sizeof(perf));
+    perf_dozed = 0;
+    fuzz_pins = 0xff;
+    GIMSK = (1 << PCIE);  // main() turns PCINT on at boot
+    press_open = 0;
+    last_count = 0;
+}
+
+static void check_queues(void) {
+    CHECK(! perf.dropped, "event queue overflow");
+    CHECK(state_stack_len <= STATE_STACK_SIZE, "state stack overflow");
+}
+
+// set the switch, and run the PCINT interrupt if it changed
+// (and it's on ... standby_mode() turns it off after waking)
+static void set_switch(uint8_t pressed) {
+    uint8_t pins = pressed ? (fuzz_pins & ~(1 << SWITCH_PIN))
+                           : (fuzz_pins | (1 << SWITCH_PIN));
+    if (pins == fuzz_pins) return;
+    fuzz_pins = pins;
+    if (GIMSK & (1 << PCIE)) PCINT0_vect();
+    if (fuzz_options & FUZZ_PCINT_INNER) {
+        uint8_t was_pressed = button_last_state;
+        // (a bounce can read the same as the last change)
+        if (button_is_pressed() != was_pressed)
+            PCINT_inner(button_last_state);
+        process_emissions();
+        check_queues();
+    }
+}
+
+// the same as fsm-main.c's, for the interrupts which buttons use
+uint8_t handle_deferred_interrupts() {
+    uint8_t handled = 0;
+    if (irq_pending(IRQ_PCINT)) {
+        irq_done(IRQ_PCINT);
+        go_to_standby = 0;
+        handled |= (1 << IRQ_PCINT);
+    }
+    if (irq_pending(IRQ_WDT)) {
+        irq_done(IRQ_WDT);
+        uint16_t before = ticks_since_last_event;
+        Event event_before = current_event;
+        uint8_t pressed_before = button_last_state;
+        WDT_inner();
+        // (only something happening may reset the count)
+        CHECK((before < 0x8000) || (ticks_since_last_event >= 0x8000)
+              || (current_event != event_before)
+              || (button_last_state != pressed_before),
+              "ticks_since_last_event rolled back below 0x8000");
+        check_queues();
+        handled |= (1 << IRQ_WDT);
+    }
+    return handled;
+}
+
+// one clock tick, like the main loop handles it
+static void tick(void) {
+    WDT_vect();
+    handle_deferred_interrupts();
+    process_emissions();
+    check_queues();
+}
+
+// one step of the input: set the switch, return how many ticks it stays
+static uint8_t next_step(void) {
+    uint8_t step = *steps++;
+    steps_left --;
+    set_switch(step & 1);
+    return step >> 1;
+}
+
+// standby_mode() sleeps here, until the next step wakes it
+static void fuzz_sleep(void) {
+    if (! steps_left) {
+        // out of input, so wake up with a glitch too short to read
+        PCINT0_vect();
+        return;
+    }
+    uint8_t pins = fuzz_pins;
+    uint8_t ticks = next_step();
+    if (pins == fuzz_pins) {
+        if (ticks) WDT_vect();  // a sleep tick
+    }
+    // a 0-tick press is over before standby_mode() reads the pin
+    else if (! ticks) fuzz_pins = pins;
+    // a 1-tick press lands on a sleep tick, so the WDT sees it first
+    // (longer ones are left for the fast-wake check)
+    else if (ticks == 1) WDT_vect();
+}
+
+// go to standby, the way the main loop does it
+static void standby(void) {
+    // (standby_mode() would wait forever for the switch to be let go)
+    CHECK(fuzz_pins & (1 << SWITCH_PIN), "standby while the switch is down");
+    standby_mode();
+    process_emissions();
+    check_queues();
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size < 4) return 0;
+    fsm_reset();
+    ui_actions = data[0] & 0x0f;
+    hold_limit = data[0] >> 4;
+    ticks_since_last_event = data[1] | (data[2] << 8);
+    fuzz_options = data[3];
+    steps = data + 4;
+    steps_left = size - 4;
+    CHECK(push_state(fuzz_state, 0) > 0, "can't push the first state");
+
+    while (steps_left) {
+        for (uint8_t n = next_step(); n; n--) {
+            tick();
+            // (standby uses up steps of its own, so start a new one after)
+            if (go_to_standby) {
+                standby();
+                break;
+            }
+        }
+    }
+
+    // let go, and give the last sequence time to finish
+    set_switch(0);
+    for (uint8_t n = 0; n < HOLD_TIMEOUT + RELEASE_TIMEOUT + 4; n++) {
+        tick();
+        if (go_to_standby) standby();
+    }
+    CHECK(! press_open, "a press never got a release");
+    CHECK(current_event == EV_none, "a button sequence never finished");
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+static uint32_t rng = 1;
+static uint32_t random32(void) {  // xorshift32
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+static int run_file(const char *path) {
+    static uint8_t buf[65536];
+    FILE *fp = fopen(path, "rb");
+    if (! fp) { perror(path); return 1; }
+    size_t size = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+    LLVMFuzzerTestOneInput(buf, size);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned long runs = 1000000;
+    int files = 0;
+    for (int i = 1; i < argc; i++) {
+        if ((! strcmp(argv[i], "-n")) && (i+1 < argc))
+            runs = strtoul(argv[++i], NULL, 0);
+        else if ((! strcmp(argv[i], "-s")) && (i+1 < argc))
+            rng = strtoul(argv[++i], NULL, 0) | 1;
+        else {
+            if (run_file(argv[i])) return 1;
+            files ++;
+        }
+    }
+    if (files) {
+        printf("%d files OK\n", files);
+        return 0;
+    }
+
+    uint8_t buf[64];
+    for (unsigned long r = 0; r < runs; r++) {
+        size_t size = 4 + (random32() % (sizeof(buf) - 4));
+        buf[0] = random32();
+        buf[1] = random32();
+        buf[2] = random32();
+        if (random32() & 1) buf[2] |= 0x7f;  // start near the rollover
+        buf[3] = random32();
+        for (size_t i = 4; i < size; i++) {
+            uint32_t x = random32();
+            // mostly alternating quick clicks, with some bounces
+            // and some long holds / pauses
+            uint8_t level = (x % 10) ? (i & 1) : ((x >> 4) & 1);
+            uint8_t ticks = ((x >> 8) % 10) < 7 ? 1 + ((x >> 12) & 7)
+                          : ((x >> 8) % 10) < 9 ? 0
+                          : (x >> 16) & 0x7f;
+            buf[i] = (ticks << 1) | level;
+        }
+        LLVMFuzzerTestOneInput(buf, size);
+    }
+    printf("%lu random inputs OK\n", runs);
+    return 0;
+}
+#endif
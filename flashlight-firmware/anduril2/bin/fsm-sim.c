@@ -0,0 +1,604 @@
+/*
+ * fsm-sim.c: Runs a SpaghettiMonster build in simavr, and reports timing.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Build (needs simavr and libelf):
+ *   cc -O2 -o fsm-sim fsm-sim.c $(pkg-config --cflags --libs simavr) -lelf
+ *
+ * Usage: fsm-sim [options] firmware.elf
+ *   -m MCU        MCU name, like attiny1634
+ *   -f HZ         clock speed (F_CPU)
+ *   -w ADDR       treat a write to this data address as "light output"
+ *                 (repeat for each PWM / DAC register, both bytes if 16-bit)
+ *   -s PORT:PIN   e-switch pin, like B:2 (held high, not pressed)
+ *   -e FILE       load EEPROM contents from a raw dump
+ *   -p SECONDS    press (and hold) the e-switch at this time (needs -s)
+ *   -b T1,T2,...  press the e-switch at T1, release at T2, press at T3...
+ *                 (in seconds, needs -s)
+ *   -v MV         battery / VCC voltage, in millivolts (default 3700)
+ *   -a CH:MV      drive ADC channel CH with MV millivolts (voltage divider)
+ *   -F NAME=ADDR  time each call to the function at this flash byte address
+ *                 (repeat for each function, ISRs too)
+ *   -S SECONDS    from this time on, measure standby: cycles awake per wake
+ *   -P ADDR:LEN   read FSM probes from the probe_trace ring at this data
+ *                 address, LEN entries long (a USE_PROBES build)
+ *   -g PORT:PIN   the PROBE_PIN of a USE_PROBES build
+ *   -V FILE       write the probes (-P) and probe pin (-g) to a VCD file
+ *   -E ADDR:LEN   read UI events and state changes from the event_trace
+ *                 ring at this data address, LEN entries long
+ *                 (a USE_EVENT_TRACE build)
+ *   -C ADDR       trace state changes by watching the current_state
+ *                 pointer at this data address instead (any build)
+ *   -T FILE       write a trace of the run to FILE: switch presses and
+ *                 releases, light output (-w) changes, and with -E, every
+ *                 event and state change (or with -C, state changes)
+ *   -t SECONDS    stop after this much simulated time (default 2)
+ *
+ * Prints one "name value" line per result:
+ *   first_light     cycles from reset to the first nonzero light output write
+ *   press_to_light  cycles from the -p press to the next nonzero write
+ * ("none" if it never happened)
+ * and with -F, one line per function:
+ *   func NAME calls N min CYCLES avg CYCLES max CYCLES
+ * (cycles from entry until it returns, including any interrupts in between)
+ * and with -S:
+ *   standby_wakes N
+ *   standby_awake_cycles CYCLES
+ * and with -P, one line per probe:
+ *   probe NAME count N cycles CYCLES
+ * (how many times it started, and total cycles while it was active,
+ *  so "probe sleep" over the run time is the sleep residency)
+ *
+ * The -T trace has one line per thing which happened, in order:
+ *   MS press / MS release
+ *   MS light ADDR VALUE  (only when a -w register's value changes)
+ *   MS event EVENT ARG
+ *   MS state ADDR        (the new state function's flash byte address)
+ * with MS in milliseconds since reset.  (ui_trace.py puts names on these)
+ *
+ * With -b, -F, -S, -P, -g, or -T, it runs for the whole -t time instead of
+ * stopping at the first light.
+ *
+ * Used by boot_bench.py, cycle_bench.py, and ui_trace.py, which find the
+ * registers, pins, and function addresses for each cfg.
+ */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "avr_ioport.h"
+#include "avr_eeprom.h"
+#include "avr_adc.h"
+
+#define MAX_WATCHED 16
+#define MAX_TOGGLES 256
+#define MAX_PROFILED 32
+#define MAX_ACTIVE 64
+
+// probe names, in the same order as the probe IDs in fsm-probe.h
+static const char *probe_names[] = {
+    "wdt_isr", "adc_isr", "pcint_isr", "timer_isr", "wdt_inner",
+    "adc_deferred", "process_emissions", "set_level", "standby", "sleep",
+};
+#define PROBE_IDS (sizeof(probe_names) / sizeof(probe_names[0]))
+#define PROBE_EXIT 0x80
+
+static avr_cycle_count_t first_light = 0;
+static avr_cycle_count_t pressed_at = 0;
+static avr_cycle_count_t press_light = 0;
+
+// one timed function
+typedef struct {
+    const char *name;
+    uint32_t addr;
+    uint32_t calls;
+    avr_cycle_count_t min, max, total;
+} profiled_t;
+static profiled_t profiled[MAX_PROFILED];
+static int num_profiled = 0;
+
+// calls in progress, innermost last
+typedef struct {
+    int func;
+    uint16_t sp;
+    avr_cycle_count_t start;
+} active_t;
+static active_t active[MAX_ACTIVE];
+static int num_active = 0;
+
+// scheduled switch changes, for -b
+typedef struct {
+    avr_irq_t *irq;
+    int level;
+} toggle_t;
+static toggle_t toggles[MAX_TOGGLES];
+
+// probe state, for -P / -g / -V
+typedef struct {
+    int depth;  // (probes can nest, like set_level() jump starts)
+    uint32_t count;
+    avr_cycle_count_t start, total;
+} probe_t;
+static probe_t probes[PROBE_IDS];
+static uint16_t probe_addr = 0;
+static int probe_len = 0;
+static int probe_seen = 0;
+static FILE *vcd = NULL;
+static uint32_t vcd_freq = 0;
+static avr_cycle_count_t vcd_last = ~(avr_cycle_count_t)0;
+#define VCD_PIN PROBE_IDS  // the probe pin's signal, after the probes
+
+// trace state, for -T / -E
+static FILE *trace = NULL;
+static uint32_t trace_freq = 0;
+static uint16_t event_addr = 0;
+static int event_len = 0;
+static int event_seen = 0;
+static uint16_t state_addr = 0;
+static uint16_t state_last = 0;  // (NULL at reset)
+static uint16_t state_pending = 0;
+#define EVENT_SIZE 3  // event_trace entries: Event, then a uint16_t arg
+
+// one light output register
+typedef struct {
+    avr_io_addr_t addr;
+    int seen;
+    uint8_t value;
+} light_t;
+static light_t lights[MAX_WATCHED];
+
+static void trace_line(avr_t *avr, const char *fmt, ...) {
+    if (! trace) return;
+    va_list ap;
+    va_start(ap, fmt);
+    fprintf(trace, "%.3f ", avr->cycle * 1000.0 / trace_freq);
+    vfprintf(trace, fmt, ap);
+    va_end(ap);
+}
+
+// called for every write to a light output register
+static void light_write(struct avr_t *avr, avr_io_addr_t addr,
+                        uint8_t v, void *param) {
+    light_t *l = (light_t *)param;
+    avr->data[addr] = v;  // other handlers (timers) may also be chained
+    if ((! l->seen) || (v != l->value))
+        trace_line(avr, "light 0x%02x %u\n", addr, v);
+    l->seen = 1;
+    l->value = v;
+    if (! v) return;
+    if (! first_light) first_light = avr->cycle;
+    if (pressed_at && (! press_light)) press_light = avr->cycle;
+}
+
+// pull the e-switch pin low, at exactly the requested cycle
+static avr_cycle_count_t press_switch(avr_t *avr, avr_cycle_count_t when,
+                                      void *param) {
+    avr_raise_irq((avr_irq_t *)param, 0);
+    pressed_at = when;
+    trace_line(avr, "press\n");
+    return 0;  // don't repeat
+}
+
+// press or release the e-switch, for -b
+static avr_cycle_count_t toggle_switch(avr_t *avr, avr_cycle_count_t when,
+                                       void *param) {
+    (void)when;
+    toggle_t *t = (toggle_t *)param;
+    avr_raise_irq(t->irq, t->level);
+    trace_line(avr, t->level ? "release\n" : "press\n");
+    return 0;
+}
+
+static uint16_t stack_pointer(avr_t *avr) {
+    return avr->data[R_SPL] | (avr->data[R_SPH] << 8);
+}
+
+// called before each instruction, when any functions are being timed
+static void profile_step(avr_t *avr) {
+    uint16_t sp = stack_pointer(avr);
+    // anything which returned (the stack is above where it was on entry)
+    while (num_active && (sp > active[num_active-1].sp)) {
+        active_t *a = &active[--num_active];
+        profiled_t *p = &profiled[a->func];
+        avr_cycle_count_t c = avr->cycle - a->start;
+        if ((! p->calls) || (c < p->min)) p->min = c;
+        if (c > p->max) p->max = c;
+        p->total += c;
+        p->calls ++;
+    }
+    // anything starting
+    for (int i = 0; i < num_profiled; i++) {
+        if (avr->pc == profiled[i].addr) {
+            if (num_active >= MAX_ACTIVE) break;  // runaway recursion
+            active[num_active].func = i;
+            active[num_active].sp = sp;
+            active[num_active].start = avr->cycle;
+            num_active ++;
+            break;
+        }
+    }
+}
+
+// VCD signal IDs are single printable characters, starting at '!'
+static void vcd_write(avr_cycle_count_t cycle, unsigned signal, int value) {
+    if (! vcd) return;
+    if (cycle != vcd_last) {
+        vcd_last = cycle;
+        fprintf(vcd, "#%llu\n",
+                (unsigned long long)(cycle * 1000000000ULL / vcd_freq));
+    }
+    fprintf(vcd, "%d%c\n", value ? 1 : 0, '!' + signal);
+}
+
+static void vcd_header(void) {
+    fprintf(vcd, "$timescale 1ns $end\n$scope module fsm $end\n");
+    for (unsigned i = 0; i < PROBE_IDS; i++)
+        fprintf(vcd, "$var wire 1 %c %s $end\n", '!' + i, probe_names[i]);
+    fprintf(vcd, "$var wire 1 %c probe_pin $end\n", (int)('!' + VCD_PIN));
+    fprintf(vcd, "$upscope $end\n$enddefinitions $end\n");
+    for (unsigned i = 0; i <= VCD_PIN; i++) vcd_write(0, i, 0);
+}
+
+// called after each instruction: handle any new probe_trace entries
+static void probe_poll(avr_t *avr) {
+    int head = avr->data[probe_addr];
+    while (probe_seen != head) {
+        uint8_t event = avr->data[probe_addr + 1 + probe_seen];
+        probe_seen = (probe_seen + 1) & (probe_len - 1);
+        unsigned id = event & ~PROBE_EXIT;
+        if (id >= PROBE_IDS) continue;
+        probe_t *p = &probes[id];
+        if (event & PROBE_EXIT) {
+            if ((! p->depth) || --p->depth) continue;
+            p->total += avr->cycle - p->start;
+            vcd_write(avr->cycle, id, 0);
+        } else {
+            p->count ++;
+            if (p->depth++) continue;
+            p->start = avr->cycle;
+            vcd_write(avr->cycle, id, 1);
+        }
+    }
+}
+
+// called after each instruction: handle any new event_trace entries
+static void event_poll(avr_t *avr) {
+    int head = avr->data[event_addr];
+    while (event_seen != head) {
+        uint8_t *e = &avr->data[event_addr + 1 + (event_seen * EVENT_SIZE)];
+        event_seen = (event_seen + 1) & (event_len - 1);
+        uint16_t arg = e[1] | (e[2] << 8);
+        // (EV_none means a state change, and function pointers are
+        //  word addresses)
+        if (e[0]) trace_line(avr, "event %u %u\n", e[0], arg);
+        else trace_line(avr, "state 0x%04x\n", arg * 2);
+    }
+}
+
+// called after each instruction: has current_state changed?
+// (it's written one byte at a time, so a new value only counts once it
+//  has stayed the same for an instruction)
+static void state_poll(avr_t *avr) {
+    uint16_t v = avr->data[state_addr] | (avr->data[state_addr + 1] << 8);
+    if ((v == state_pending) && (v != state_last)) {
+        trace_line(avr, "state 0x%04x\n", v * 2);
+        state_last = v;
+    }
+    state_pending = v;
+}
+
+// the probe pin changed
+static void probe_pin(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void)irq;
+    vcd_write(((avr_t *)param)->cycle, VCD_PIN, value);
+}
+
+static int load_eeprom_file(avr_t *avr, const char *path) {
+    static uint8_t buf[4096];
+    FILE *fp = fopen(path, "rb");
+    if (! fp) { perror(path); return 1; }
+    size_t size = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+    avr_eeprom_desc_t desc = { .ee = buf, .offset = 0, .size = size };
+    avr_ioctl(avr, AVR_IOCTL_EEPROM_SET, &desc);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    const char *mcu = NULL;
+    uint32_t freq = 0;
+    avr_io_addr_t watched[MAX_WATCHED];
+    int num_watched = 0;
+    char switch_port = 0;
+    int switch_pin = 0;
+    const char *eeprom_file = NULL;
+    double press = 0.0;
+    double toggle_times[MAX_TOGGLES];
+    int num_toggles = 0;
+    uint32_t millivolts = 3700;
+    int adc_channel = -1;
+    uint32_t adc_millivolts = 0;
+    double standby = 0.0;
+    char probe_port = 0;
+    int probe_pin_num = 0;
+    const char *vcd_file = NULL;
+    const char *trace_file = NULL;
+    double seconds = 2.0;
+    const char *elf = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *a = argv[i];
+        if ((a[0] == '-') && (i+1 >= argc)) {
+            fprintf(stderr, "%s needs a value\n", a);
+            return 2;
+        }
+        if (! strcmp(a, "-m")) mcu = argv[++i];
+        else if (! strcmp(a, "-f")) freq = strtoul(argv[++i], NULL, 0);
+        else if (! strcmp(a, "-w")) {
+            if (num_watched >= MAX_WATCHED) {
+                fprintf(stderr, "too many -w registers\n");
+                return 2;
+            }
+            watched[num_watched++] = strtoul(argv[++i], NULL, 0);
+        }
+        else if (! strcmp(a, "-s")) {
+            if (sscanf(argv[++i], "%c:%d", &switch_port, &switch_pin) != 2) {
+                fprintf(stderr, "bad switch pin: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (! strcmp(a, "-e")) eeprom_file = argv[++i];
+        else if (! strcmp(a, "-p")) press = atof(argv[++i]);
+        else if (! strcmp(a, "-b")) {
+            char *list = argv[++i];
+            char *end;
+            while (*list && (num_toggles < MAX_TOGGLES)) {
+                toggle_times[num_toggles++] = strtod(list, &end);
+                if (end == list) break;
+                list = (*end == ',') ? end + 1 : end;
+            }
+        }
+        else if (! strcmp(a, "-v")) millivolts = strtoul(argv[++i], NULL, 0);
+        else if (! strcmp(a, "-a")) {
+            if (sscanf(argv[++i], "%d:%u", &adc_channel,
+                       &adc_millivolts) != 2) {
+                fprintf(stderr, "bad ADC input: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (! strcmp(a, "-F")) {
+            char *eq = strchr(argv[++i], '=');
+            if ((! eq) || (num_profiled >= MAX_PROFILED)) {
+                fprintf(stderr, "bad or too many -F: %s\n", argv[i]);
+                return 2;
+            }
+            *eq = 0;
+            profiled[num_profiled].name = argv[i];
+            profiled[num_profiled].addr = strtoul(eq + 1, NULL, 0);
+            num_profiled ++;
+        }
+        else if (! strcmp(a, "-S")) standby = atof(argv[++i]);
+        else if (! strcmp(a, "-P")) {
+            unsigned addr;
+            if ((sscanf(argv[++i], "%i:%d", &addr, &probe_len) != 2)
+                    || (probe_len < 1) || (probe_len > 256)
+                    || (probe_len & (probe_len - 1))) {
+                fprintf(stderr, "bad probe trace: %s\n", argv[i]);
+                return 2;
+            }
+            probe_addr = addr;
+        }
+        else if (! strcmp(a, "-g")) {
+            if (sscanf(argv[++i], "%c:%d", &probe_port, &probe_pin_num) != 2) {
+                fprintf(stderr, "bad probe pin: %s\n", argv[i]);
+                return 2;
+            }
+        }
+        else if (! strcmp(a, "-V")) vcd_file = argv[++i];
+        else if (! strcmp(a, "-E")) {
+            unsigned addr;
+            if ((sscanf(argv[++i], "%i:%d", &addr, &event_len) != 2)
+                    || (event_len < 1) || (event_len > 64)
+                    || (event_len & (event_len - 1))) {
+                fprintf(stderr, "bad event trace: %s\n", argv[i]);
+                return 2;
+            }
+            event_addr = addr;
+        }
+        else if (! strcmp(a, "-C")) state_addr = strtoul(argv[++i], NULL, 0);
+        else if (! strcmp(a, "-T")) trace_file = argv[++i];
+        else if (! strcmp(a, "-t")) seconds = atof(argv[++i]);
+        else if (a[0] == '-') {
+            fprintf(stderr, "unknown option: %s\n", a);
+            return 2;
+        }
+        else elf = a;
+    }
+    if ((! elf) || (! mcu) || (! freq)) {
+        fprintf(stderr, "Usage: fsm-sim -m MCU -f HZ [-w ADDR ...] "
+                        "[-s PORT:PIN] [-e FILE] [-p SECONDS] "
+                        "[-b T1,T2,...] [-v MV] [-a CH:MV] [-F NAME=ADDR ...] "
+                        "[-S SECONDS] [-P ADDR:LEN] [-g PORT:PIN] [-V FILE] "
+                        "[-E ADDR:LEN] [-C ADDR] [-T FILE] [-t SECONDS] "
+                        "file.elf\n");
+        return 2;
+    }
+    if ((press || num_toggles) && (! switch_port)) {
+        fprintf(stderr, "-p and -b need -s\n");
+        return 2;
+    }
+    if (vcd_file && (! probe_len) && (! probe_port)) {
+        fprintf(stderr, "-V needs -P or -g\n");
+        return 2;
+    }
+    if ((event_len || state_addr) && (! trace_file)) {
+        fprintf(stderr, "-E and -C need -T\n");
+        return 2;
+    }
+    // run the whole time, not just until the light turns on
+    int full_run = num_toggles || num_profiled || (standby > 0.0)
+                   || probe_len || probe_port || trace_file;
+
+    elf_firmware_t fw;
+    memset(&fw, 0, sizeof(fw));
+    if (elf_read_firmware(elf, &fw)) {
+        fprintf(stderr, "can't read %s\n", elf);
+        return 1;
+    }
+    strncpy(fw.mmcu, mcu, sizeof(fw.mmcu) - 1);
+    fw.frequency = freq;
+
+    avr_t *avr = avr_make_mcu_by_name(mcu);
+    if (! avr) {
+        fprintf(stderr, "simavr doesn't support %s\n", mcu);
+        return 3;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, &fw);
+    avr->log = LOG_ERROR;
+    avr->vcc = avr->avcc = millivolts;
+    if (adc_channel >= 0) {
+        avr_irq_t *irq = avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ,
+                                       ADC_IRQ_ADC0 + adc_channel);
+        if (! irq) {
+            fprintf(stderr, "no such ADC channel: %d\n", adc_channel);
+            return 2;
+        }
+        avr_raise_irq(irq, adc_millivolts);
+    }
+
+    if (eeprom_file && load_eeprom_file(avr, eeprom_file)) return 1;
+
+    if (vcd_file) {
+        vcd = fopen(vcd_file, "w");
+        if (! vcd) { perror(vcd_file); return 1; }
+        vcd_freq = freq;
+        vcd_header();
+    }
+    if (trace_file) {
+        trace = fopen(trace_file, "w");
+        if (! trace) { perror(trace_file); return 1; }
+        trace_freq = freq;
+    }
+    if (probe_port) {
+        avr_irq_t *irq = avr_io_getirq(avr,
+                AVR_IOCTL_IOPORT_GETIRQ(probe_port), probe_pin_num);
+        if (! irq) {
+            fprintf(stderr, "no such pin: %c:%d\n", probe_port, probe_pin_num);
+            return 2;
+        }
+        avr_irq_register_notify(irq, probe_pin, avr);
+    }
+
+    for (int i = 0; i < num_watched; i++) {
+        lights[i].addr = watched[i];
+        avr_register_io_write(avr, watched[i], light_write, &lights[i]);
+    }
+
+    // nothing drives the pull-up in simavr, so hold the switch high
+    // (otherwise the firmware sees a button held down at boot)
+    if (switch_port) {
+        avr_irq_t *irq = avr_io_getirq(avr,
+                AVR_IOCTL_IOPORT_GETIRQ(switch_port), switch_pin);
+        if (! irq) {
+            fprintf(stderr, "no such pin: %c:%d\n", switch_port, switch_pin);
+            return 2;
+        }
+        avr_raise_irq(irq, 1);
+        if (press) {
+            avr_cycle_timer_register(avr, (avr_cycle_count_t)(press * freq),
+                                     press_switch, irq);
+            if (press >= seconds) seconds = press + 1.0;
+        }
+        for (int i = 0; i < num_toggles; i++) {
+            toggles[i].irq = irq;
+            toggles[i].level = i & 1;  // press, release, press...
+            avr_cycle_timer_register(avr,
+                    (avr_cycle_count_t)(toggle_times[i] * freq),
+                    toggle_switch, &toggles[i]);
+        }
+    }
+
+    // run until everything requested has been seen
+    avr_cycle_count_t limit = (avr_cycle_count_t)(seconds * freq);
+    avr_cycle_count_t standby_start = (avr_cycle_count_t)(standby * freq);
+    uint32_t standby_wakes = 0;
+    avr_cycle_count_t standby_awake = 0;
+    int state = cpu_Running;
+    while ((state != cpu_Done) && (state != cpu_Crashed)
+           && (avr->cycle < limit)
+           && (full_run || (! first_light) || (press && (! press_light)))) {
+        int was = avr->state;
+        avr_cycle_count_t before = avr->cycle;
+        if (num_profiled && (was == cpu_Running)) profile_step(avr);
+        state = avr_run(avr);
+        if (probe_len) probe_poll(avr);
+        if (event_len) event_poll(avr);
+        if (state_addr) state_poll(avr);
+        if (standby_start && (before >= standby_start)) {
+            if (was == cpu_Running) standby_awake += avr->cycle - before;
+            else if ((was == cpu_Sleeping) && (state == cpu_Running))
+                standby_wakes ++;
+        }
+    }
+    if (state == cpu_Crashed) {
+        fprintf(stderr, "simulated MCU crashed at cycle %llu\n",
+                (unsigned long long)avr->cycle);
+        return 1;
+    }
+
+    if (first_light) printf("first_light %llu\n",
+                            (unsigned long long)first_light);
+    else printf("first_light none\n");
+    if (press) {
+        if (press_light) printf("press_to_light %llu\n",
+                                (unsigned long long)(press_light - pressed_at));
+        else printf("press_to_light none\n");
+    }
+    for (int i = 0; i < num_profiled; i++) {
+        profiled_t *p = &profiled[i];
+        if (! p->calls) {
+            printf("func %s calls 0\n", p->name);
+            continue;
+        }
+        printf("func %s calls %u min %llu avg %llu max %llu\n", p->name,
+               p->calls, (unsigned long long)p->min,
+               (unsigned long long)(p->total / p->calls),
+               (unsigned long long)p->max);
+    }
+    for (unsigned i = 0; probe_len && (i < PROBE_IDS); i++) {
+        probe_t *p = &probes[i];
+        // (count anything still active up to the end)
+        avr_cycle_count_t total = p->total;
+        if (p->depth) total += avr->cycle - p->start;
+        printf("probe %s count %u cycles %llu\n", probe_names[i],
+               p->count, (unsigned long long)total);
+    }
+    if (vcd) fclose(vcd);
+    if (trace) fclose(trace);
+    if (standby > 0.0) {
+        printf("standby_wakes %u\n", standby_wakes);
+        printf("standby_awake_cycles %llu\n",
+               (unsigned long long)standby_awake);
+    }
+    return 0;
+}
@@ -0,0 +1,96 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import struct
+import sys
+
+# same layout as PerfCounters in fsm-perf.h (avr-gcc doesn't pad)
+PERF_MAGIC = 0xc2
+PERF_FORMAT = '<BBHHHIIIHHHHH'
+PERF_FIELDS = ('magic', 'queue_max', 'dropped', 'merged_ticks', 'late_ticks',
+               'awake_ticks', 'idle_ticks', 'sleep_ticks', 'lvp_events',
+               'thermal_events', 'pcint_irqs', 'wdt_irqs', 'adc_irqs')
+PERF_SIZE = struct.calcsize(PERF_FORMAT)
+
+
+def main(args):
+    """Decodes SpaghettiMonster's performance counters (USE_PERF_COUNTERS)
+    from an EEPROM or RAM dump.
+
+    Usage: perf_decode.py [--offset N] dump_file
+    Options:
+      --offset N   where the counters start in the dump
+                   (default: the last bytes, where perf_save() puts them)
+
+    The dump can be raw binary or Intel hex, like from:
+      avrdude -p t1634 -c usbasp -U eeprom:r:eeprom.bin:r
+    The counters are saved to EEPROM when they're blinked out (14 clicks
+    from off).  For a RAM dump (from a debugger or simulator), use the
+    address of "perf" from avr-nm, minus 0x800000, as the offset.
+    """
+    offset = None
+    path = None
+
+    i = 0
+    while i < len(args):
+        a = args[i]
+        if a == '--offset':
+            i += 1
+            offset = int(args[i], 0)
+        elif a.startswith('-'):
+            print(main.__doc__)
+            return 2
+        else:
+            path = a
+        i += 1
+    if not path:
+        print(main.__doc__)
+        return 2
+
+    data = read_dump(path)
+    if offset is None:
+        offset = len(data) - PERF_SIZE
+    if (offset < 0) or (offset + PERF_SIZE > len(data)):
+        print('dump is too short')
+        return 1
+    values = dict(zip(PERF_FIELDS, struct.unpack_from(PERF_FORMAT, data,
+                                                      offset)))
+    if values['magic'] != PERF_MAGIC:
+        print('no counters found at offset %i (magic is 0x%02x, not 0x%02x)'
+              % (offset, values['magic'], PERF_MAGIC))
+        return 1
+
+    for name in PERF_FIELDS[1:]:
+        print('%-16s %i' % (name, values[name]))
+    if values['awake_ticks']:
+        print('%-16s %.1f%%' % ('idle', 100.0 * values['idle_ticks']
+                                / values['awake_ticks']))
+    return 0
+
+
+def read_dump(path):
+    """Returns a memory dump's contents, from raw binary or Intel hex."""
+    with open(path, 'rb') as fp:
+        raw = fp.read()
+    if not raw.startswith(b':'):
+        return bytearray(raw)
+    data = bytearray()
+    for line in raw.decode().splitlines():
+        line = line.strip()
+        if not line.startswith(':'):
+            continue
+        record = bytearray.fromhex(line[1:])
+        count, addr, kind = record[0], (record[1] << 8) | record[2], record[3]
+        if kind == 1:  # end of file
+            break
+        if kind != 0:  # (EEPROM dumps don't need extended addresses)
+            continue
+        if len(data) < addr + count:
+            data.extend(b'\xff' * (addr + count - len(data)))
+        data[addr:addr + count] = record[4:4 + count]
+    return data
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,356 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import os
+import re
+import subprocess
+import sys
+
+from anduril_build import MCU_SIZES
+
+# bytes pushed by a call / rcall / interrupt (return address)
+RETURN_ADDRESS = 2
+
+# stack used by libgcc / avr-libc helpers, which aren't in anduril.su
+# (anything else defaults to 0, plus the return address)
+LIB_FRAMES = {
+    '__udivmodqi4': 0, '__divmodqi4': 0,
+    '__udivmodhi4': 0, '__divmodhi4': 2,
+    '__udivmodsi4': 0, '__divmodsi4': 4,
+    '__mulhi3': 0, '__mulsi3': 0, '__umulhisi3': 0,
+    '__tablejump2__': 0, '__tablejump__': 0,
+    '__eerd_byte_tn85': 0, '__eewr_byte_tn85': 0,
+}
+
+
+def main(args):
+    """Estimates worst-case stack use for an Anduril build, and checks
+    that it fits in SRAM along with the static variables.
+
+    Usage: stack_check.py [options] --mcu N build_dir
+    Options:
+      --mcu N          MCU number, like 85 or 1634 (required)
+      --nesting N      how many extra times a recursive cycle may run
+                       (default 1, like nice_delay_ms() -> ... -> a state
+                        -> nice_delay_ms() once)
+      --margin N       fail if fewer than N bytes would be left (default 0)
+      -v               show the deepest call chain
+
+    build_dir needs anduril.o, anduril.su (from -fstack-usage), and
+    anduril.elf, like the ones "make" puts in build/<target>/.
+
+    Frame sizes come from anduril.su.  Calls come from the disassembly of
+    anduril.elf, where objdump names each call's target (a call it can't
+    name fails the check, if anything reaches it).  An indirect call
+    (icall, like the state callbacks in emit_now() and _set_state()) may
+    go to any function whose address is taken anywhere (every state,
+    basically), going by the function pointer relocations in anduril.o.
+    Interrupts don't nest, so the deepest ISR is added once, on top of
+    the deepest main path.  Functions which call each other in a loop
+    (recursion) count as one big frame, with every function in the loop
+    in it once, plus --nesting more laps of the whole loop.  Each loop
+    found is listed.
+
+    Exits with status 1 if stack + .data + .bss + .noinit is bigger than
+    the MCU's SRAM (minus --margin), or if a call couldn't be resolved.
+    """
+    mcu = None
+    nesting = 1
+    margin = 0
+    verbose = False
+    build_dir = None
+
+    i = 0
+    while i < len(args):
+        a = args[i]
+        if a == '--mcu':
+            i += 1
+            mcu = int(args[i])
+        elif a == '--nesting':
+            i += 1
+            nesting = int(args[i])
+        elif a == '--margin':
+            i += 1
+            margin = int(args[i])
+        elif a == '-v':
+            verbose = True
+        elif a.startswith('-'):
+            print(main.__doc__)
+            return 2
+        else:
+            build_dir = a
+        i += 1
+    if (mcu not in MCU_SIZES) or (not build_dir):
+        print(main.__doc__)
+        return 2
+
+    obj = os.path.join(build_dir, 'anduril.o')
+    elf = os.path.join(build_dir, 'anduril.elf')
+    frames = read_stack_usage(os.path.join(build_dir, 'anduril.su'))
+    calls, indirect, address_taken, unresolved = call_graph(elf, obj)
+    static = static_ram(elf)
+
+    graph = Graph(frames, calls, indirect, address_taken, unresolved,
+                  nesting)
+    main_depth, main_chain = graph.worst('main')
+    isr_depth, isr_chain = 0, []
+    for f in sorted(calls):
+        if re.match(r'^__vector_\d+$', f):
+            d, chain = graph.worst(f)
+            if d > isr_depth:
+                isr_depth, isr_chain = d, chain
+    if isr_chain:
+        isr_depth += RETURN_ADDRESS
+
+    stack = main_depth + isr_depth
+    sram = MCU_SIZES[mcu][1]
+    free = sram - static - stack
+
+    print('static RAM: %i bytes' % static)
+    print('main: %i bytes (%s)' % (main_depth, short_chain(main_chain)))
+    for lap, members in graph.recursion():
+        print('recursion: %i bytes x %i (%s)' % (lap, nesting,
+                                                 ', '.join(members)))
+    if isr_chain:
+        print('interrupt: %i bytes (%s)' % (isr_depth,
+                                            short_chain(isr_chain)))
+    print('worst case: %i of %i bytes, %i free' % (static + stack, sram,
+                                                   free))
+    if verbose:
+        for f in main_chain:
+            print('  %5i  %s' % (graph.frame(f), f))
+    unknown = graph.unknown()
+    if unknown:
+        print('no stack info (counted as 0): %s' % ' '.join(unknown))
+    lost = graph.unresolved_calls()
+    if lost:
+        for f, addrs in lost:
+            print('ERROR: %s calls somewhere unknown (%s)'
+                  % (f, ', '.join('0x%x' % a if a is not None else '?'
+                                  for a in addrs)))
+        print('ERROR: can\'t tell how deep the stack goes')
+        return 1
+    if free < margin:
+        print('ERROR: stack may overflow into static RAM')
+        return 1
+    return 0
+
+
+def short_chain(chain, limit=6):
+    if len(chain) > limit:
+        chain = chain[:2] + ['...'] + chain[-(limit - 3):]
+    return ' -> '.join(chain)
+
+
+def base_name(name):
+    """foo.constprop.0 -> foo"""
+    return name.split('.')[0] if not name.startswith('.') else name
+
+
+def read_stack_usage(path):
+    """Returns {function: bytes} from a -fstack-usage file."""
+    frames = {}
+    for line in open(path):
+        parts = line.rstrip('\n').split('\t')
+        if len(parts) < 3:
+            continue
+        name = parts[0].split(':')[-1]
+        frames[name] = int(parts[1])
+        if 'dynamic' in parts[2] and 'bounded' not in parts[2]:
+            print('warning: %s has a dynamic stack frame' % name)
+    return frames
+
+
+def objdump(*args):
+    return subprocess.check_output(('avr-objdump',) + args).decode()
+
+
+def call_graph(elf, obj):
+    """Returns ({function: set(callees)}, set(functions with an indirect
+    call), set(functions whose address is taken), {function: [call
+    targets objdump couldn't name]})."""
+    # calls come from the linked code, where every call / jump has its
+    # target in objdump's comment, like "rcall .+12 ; 0x5a4 <foo+0x8>"
+    # (not from relocations: without -mrelax, the assembler resolves
+    #  rcall / rjmp inside .text itself, and leaves no relocation)
+    text = objdump('-d', elf)
+    calls = {}
+    unresolved = {}  # {function: [target addresses]}
+    indirect = set()
+    current = None
+    for line in text.splitlines():
+        m = re.match(r'^[0-9a-f]+ <([^>]+)>:$', line)
+        if m:
+            current = m.group(1)
+            calls.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        m = re.match(r'^\s+[0-9a-f]+:\s+(?:[0-9a-f]{2} )+\s*(\w+)[^;]*'
+                     r'(?:;\s*0x([0-9a-f]+)(?: <([^>+]+))?)?', line)
+        if not m:
+            continue
+        op = m.group(1)
+        if op in ('icall', 'eicall', 'ijmp', 'eijmp'):
+            indirect.add(current)
+        elif op in ('call', 'rcall', 'jmp', 'rjmp'):
+            target = m.group(3)
+            if not target:
+                # (objdump found no symbol there, or no target at all)
+                addr = int(m.group(2), 16) if m.group(2) else None
+                unresolved.setdefault(current, []).append(addr)
+            elif target != current:
+                calls[current].add(target)
+
+    # function pointers: program-memory (word) address relocations,
+    # in code (ldi ... gs(state)) or in data (tables of states)
+    # (these are always relocations, so the object file has them all)
+    starts = []  # (offset, function) in the object's .text
+    for line in objdump('-d', obj).splitlines():
+        m = re.match(r'^([0-9a-f]+) <([^>]+)>:$', line)
+        if m:
+            starts.append((int(m.group(1), 16), m.group(2)))
+
+    def resolve(sym):
+        """.text+0x1a -> the function at that offset, foo+0x2 -> foo"""
+        m = re.match(r'^\.text\+0x([0-9a-f]+)$', sym)
+        if m:
+            offset = int(m.group(1), 16)
+            found = None
+            for start, name in starts:
+                if start <= offset:
+                    found = name
+            return found
+        return sym.split('+')[0]
+
+    address_taken = set()
+    for line in objdump('-r', obj).splitlines():
+        m = re.match(r'^[0-9a-f]+ (R_AVR_\w*(?:PM|GS)\w*)\s+(\S+)', line)
+        if m:
+            f = resolve(m.group(2))
+            if f:
+                address_taken.add(f)
+    return calls, indirect, address_taken, unresolved
+
+
+def static_ram(elf):
+    out = subprocess.check_output(['avr-size', '-A', elf]).decode()
+    total = 0
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) >= 2 and parts[0] in ('.data', '.bss', '.noinit'):
+            total += int(parts[1])
+    return total
+
+
+class Graph(object):
+    def __init__(self, frames, calls, indirect, address_taken, unresolved,
+                 nesting):
+        self.frames = frames
+        self.calls = calls
+        self.indirect = indirect
+        self.address_taken = sorted(address_taken)
+        self.unresolved = unresolved
+        self.nesting = nesting
+        self.memo = {}
+        self.cycles = []
+        self.missing = set()
+        self.reached = set()
+        # strongly connected components (Tarjan's algorithm)
+        self.component = {}
+        self.index = {}
+        self.low = {}
+        self.stack = []
+        self.on_stack = set()
+
+    def frame(self, f):
+        if f in self.frames:
+            return self.frames[f]
+        if base_name(f) in self.frames:
+            return self.frames[base_name(f)]
+        if f in LIB_FRAMES:
+            return LIB_FRAMES[f]
+        self.missing.add(f)
+        return 0
+
+    def unknown(self):
+        return sorted(self.missing)
+
+    def unresolved_calls(self):
+        """[(function, [target addresses])] for functions which were
+        walked, and have calls to nowhere (the code between symbols,
+        data in .text, etc. doesn't matter if nothing calls it)"""
+        return [(f, self.unresolved[f]) for f in sorted(self.unresolved)
+                if f in self.reached]
+
+    def callees(self, f):
+        callees = set(self.calls.get(f, ()))
+        if f in self.indirect:
+            callees.update(self.address_taken)
+        return sorted(callees)
+
+    def connect(self, f):
+        """Finds the component of f, and of everything it reaches."""
+        self.index[f] = self.low[f] = len(self.index)
+        self.stack.append(f)
+        self.on_stack.add(f)
+        self.reached.add(f)
+        for c in self.callees(f):
+            if c not in self.index:
+                self.connect(c)
+                self.low[f] = min(self.low[f], self.low[c])
+            elif c in self.on_stack:
+                self.low[f] = min(self.low[f], self.index[c])
+        if self.low[f] == self.index[f]:
+            members = []
+            while True:
+                m = self.stack.pop()
+                self.on_stack.discard(m)
+                members.append(m)
+                if m == f:
+                    break
+            component = tuple(sorted(members))
+            for m in members:
+                self.component[m] = component
+
+    def worst(self, f):
+        """Returns (bytes, chain) for the deepest path starting at f.
+        Functions which call each other in a cycle (recursion) are one
+        component: a path through it may visit every member once, plus
+        --nesting more laps of the whole cycle.  That's a bound, not an
+        exact depth, so it never depends on which way the cycle was
+        entered, and every cycle is kept for cycles()."""
+        if f not in self.component:
+            self.connect(f)
+        component = self.component[f]
+        if component not in self.memo:
+            self.memo[component] = self.component_depth(component)
+        return self.memo[component]
+
+    def component_depth(self, component):
+        inside = sum(self.frame(m) for m in component) \
+            + RETURN_ADDRESS * (len(component) - 1)
+        best, best_chain = 0, []
+        for m in component:
+            for c in self.callees(m):
+                if self.component[c] == component:
+                    continue
+                d, chain = self.worst(c)
+                d += RETURN_ADDRESS
+                if d > best:
+                    best, best_chain = d, chain
+        first = component[0]
+        if (len(component) > 1) or (first in self.callees(first)):
+            lap = sum(self.frame(m) + RETURN_ADDRESS for m in component)
+            self.cycles.append((lap, list(component)))
+            inside += lap * self.nesting
+        return inside + best, list(component) + best_chain
+
+    def recursion(self):
+        """[(bytes per lap, functions)] for every cycle walked so far."""
+        return sorted(self.cycles, reverse=True)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,319 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import shutil
+import sys
+import tempfile
+
+from anduril_build import ANDURIL_DIR, SERIES1, extract_revision, \
+    find_cfgs, get_macros, make_stubs, parse_args, print_table, value
+
+# Rough electrical model, at ~3.7V.
+# These are datasheet typicals plus a few bench numbers; override with
+# --set NAME=VALUE when better measurements are available.
+model = {
+    # power-down floor with the WDT / PIT running, in uA
+    'sleep_ua_85': 4.5,
+    'sleep_ua_1634': 4.0,
+    'sleep_ua_1616': 1.0,  # RTC PIT on the 32 kHz ULP oscillator
+    # brown-out detector left on while asleep, in uA
+    'bod_ua': 20.0,
+    'bod_sampled_ua': 1.0,
+    # MCU active current per MHz, in uA
+    'active_ua_per_mhz': 500.0,
+    # time to wake from power-down and get back to sleep, in cycles
+    'wake_overhead_cycles': 100,
+    # cycles per sleep tick (WDT_inner + EV_sleep_tick + aux update)
+    # (use --cycles to load measured numbers from simavr instead)
+    'sleep_tick_cycles': 1500,
+    # extra cycles on ticks which run the voltage handler
+    'lvp_cycles': 3000,
+    # ADC left free-running for one sleep tick (no USE_ADC_SLEEP), in uA
+    'adc_ua': 250.0,
+    # MCU + ADC in ADC sleep mode, in uA, and time per conversion in us
+    'adc_sleep_ua': 1000.0,
+    'adc_conversion_us': 210.0,
+    # voltage divider (R1 + R2), in kohm, if the light has one
+    'divider_kohm': 430.0,
+    # aux LED current per lit channel, in uA
+    'aux_low_ua': 60.0,
+    'aux_high_ua': 1500.0,
+    'button_low_ua': 60.0,
+    'button_high_ua': 1500.0,
+    'indicator_low_ua': 60.0,
+    'indicator_high_ua': 1500.0,
+    # battery for the "months" column, in mAh
+    'capacity_mah': 3000.0,
+}
+
+TICK_SECONDS = 0.016  # 62.5 Hz
+
+
+def main(args):
+    """Estimates standby current for each Anduril build target.
+
+    Usage: standby_calc.py [options] [pattern]
+    Options:
+      --cycles FILE      load "target,cycles" lines (cycles per sleep tick,
+                         from simavr) instead of using the default estimate
+      --baseline REV     also model git revision REV, and flag regressions
+      --threshold PCT    regression threshold, in percent (default 5)
+      --csv              print CSV instead of a table
+      --set NAME=VALUE   override a model parameter (see top of this file)
+
+    Reads the same cfg-*.h files as build-all.sh, using the host's cpp to
+    resolve each config (so no AVR toolchain is needed), then models:
+    wake-ups per second, CPU time per sleep tick, sleep LVP ADC time,
+    aux / button / indicator LED current in the default off and lockout
+    modes, voltage divider drain, and BOD state while asleep.
+
+    Exits with status 1 if --baseline finds a regression.
+    """
+    opts = parse_args(args, {
+        '--cycles': ('cycles', str, None),
+        '--baseline': ('baseline', str, None),
+        '--threshold': ('threshold', float, 5.0),
+        '--csv': ('csv', None, False),
+        '--set': ('set', str, []),
+        }, main.__doc__)
+    if opts is None:
+        return 2
+    for setting in opts['set']:
+        name, num = setting.split('=')
+        if name not in model:
+            print('unknown model parameter: %s' % (name,))
+            return 2
+        model[name] = float(num)
+
+    cycles = {}
+    if opts['cycles']:
+        for line in open(opts['cycles']):
+            line = line.strip()
+            if line and not line.startswith('#'):
+                name, num = line.split(',')[:2]
+                cycles[name.strip()] = float(num)
+
+    results = model_tree(ANDURIL_DIR, opts['pattern'], cycles)
+
+    old = None
+    if opts['baseline']:
+        old = model_revision(ANDURIL_DIR, opts['baseline'], opts['pattern'],
+                             cycles)
+
+    regressions = report(results, old, opts['threshold'], opts['csv'])
+    if regressions:
+        return 1
+    return 0
+
+
+def model_revision(anduril_dir, rev, pattern, cycles):
+    """Models the tree as it was at a git revision."""
+    tmp = tempfile.mkdtemp()
+    try:
+        old_dir = extract_revision(anduril_dir, rev, tmp)
+        return model_tree(old_dir, pattern, cycles)
+    finally:
+        shutil.rmtree(tmp)
+
+
+def model_tree(anduril_dir, pattern, cycles):
+    """Returns {target: result} for every matching cfg file."""
+    stubs = make_stubs()
+    try:
+        results = {}
+        for name, cfg, mcu in find_cfgs(anduril_dir, pattern):
+            macros = get_macros(anduril_dir, stubs, cfg, mcu)
+            if macros is None:
+                results[name] = None
+                continue
+            results[name] = model_target(name, mcu, macros, cycles)
+        return results
+    finally:
+        shutil.rmtree(stubs)
+
+
+# lit channels per aux color: R, RG, G, GB, B, RB, RGB,
+# then disco / rainbow / voltage, which average about 1.5
+AUX_CHANNELS = (1, 2, 1, 2, 1, 2, 3, 1.5, 1.5, 1.5)
+# (off, low, high) fractions for each pattern, blinking from aux-leds.c
+AUX_BLINK = (15/19.0, 3/19.0, 1/19.0)
+INDICATOR_BLINK = (12/16.0, 3/16.0, 1/16.0)
+
+
+def pattern_ua(pattern, low, high, blink):
+    if pattern == 0:
+        return 0.0
+    if pattern == 1:
+        return low
+    if pattern == 2:
+        return high
+    return (blink[1] * low) + (blink[2] * high)
+
+
+def led_ua(macros, mode, indicator_mode):
+    """Steady LED current in one standby mode, in uA."""
+    ua = 0.0
+    if 'USE_AUX_RGB_LEDS' in macros:
+        pattern, color = mode >> 4, mode & 0x0f
+        channels = AUX_CHANNELS[min(color, len(AUX_CHANNELS)-1)]
+        ua += channels * pattern_ua(pattern, model['aux_low_ua'],
+                                    model['aux_high_ua'], AUX_BLINK)
+    if 'USE_BUTTON_LED' in macros:
+        ua += pattern_ua(mode >> 4, model['button_low_ua'],
+                         model['button_high_ua'], AUX_BLINK)
+    if 'USE_INDICATOR_LED' in macros and indicator_mode is not None:
+        ua += pattern_ua(indicator_mode, model['indicator_low_ua'],
+                         model['indicator_high_ua'], INDICATOR_BLINK)
+    return ua
+
+
+def wake_step(macros, mode, indicator_mode, speed, speed_max):
+    """Sleep ticks per wake-up, with USE_ADAPTIVE_STANDBY."""
+    animated = False
+    step = 64 if 'USE_SLEEP_LVP' in macros else 0xffff
+    if 'USE_AUX_RGB_LEDS' in macros and (mode >> 4):
+        pattern, color = mode >> 4, mode & 0x0f
+        if pattern == 3 or color == 7:
+            animated = True
+        elif color == 8:
+            step = min(step, value(macros, 'RGB_RAINBOW_SPEED', 0x0f) + 1)
+    if 'USE_BUTTON_LED' in macros and (mode >> 4) == 3:
+        animated = True
+    if 'USE_INDICATOR_LED' in macros and indicator_mode == 3:
+        animated = True
+    if animated:
+        return 1
+    return min(step, 1 << (speed_max - speed))
+
+
+def bod_asleep(mcu, macros):
+    """Brown-out detector mode while asleep: 'off', 'sampled', or 'on'."""
+    if mcu in (25, 45, 85):
+        return 'off'  # sleep_bod_disable() before each sleep
+    if mcu == 1634:
+        # set by BODPD in the extended fuse, and the stock fuses
+        # (flash-tiny1634-fuses.sh, efuse 0xff) disable it
+        return 'off'
+    if mcu in SERIES1:
+        # writable at runtime, set by hw_setup() from BOD_SLEEP
+        mode = macros.get('BOD_SLEEP', '')
+        if 'SAMPLED' in mode:
+            return 'sampled'
+        if 'ENABLED' in mode:
+            return 'on'
+        return 'off'
+    return 'on'
+
+
+def model_target(name, mcu, macros, cycles):
+    f_cpu = value(macros, 'F_CPU', 8000000) / 1e6
+    if mcu in SERIES1:
+        floor = model['sleep_ua_1616']
+        speed_max = 6
+    elif mcu == 1634:
+        floor = model['sleep_ua_1634']
+        speed_max = 9
+    else:
+        floor = model['sleep_ua_85']
+        speed_max = 9
+
+    bod = bod_asleep(mcu, macros)
+    bod_ua = {'off': 0.0, 'sampled': model['bod_sampled_ua'],
+              'on': model['bod_ua']}[bod]
+
+    divider_ua = 0.0
+    if 'USE_VOLTAGE_DIVIDER' in macros:
+        divider_ua = 3.7 / model['divider_kohm'] * 1000.0
+
+    off_mode = value(macros, 'RGB_LED_OFF_DEFAULT', 0)
+    lockout_mode = value(macros, 'RGB_LED_LOCKOUT_DEFAULT', 0)
+    ind = value(macros, 'INDICATOR_LED_DEFAULT_MODE')
+    if ind is None:
+        if 'USE_INDICATOR_LED_WHILE_RAMPING' in macros:
+            ind = (2 << 2) + 1
+        else:
+            ind = (3 << 2) + 1
+
+    active_ua = model['active_ua_per_mhz'] * f_cpu
+    tick_cycles = cycles.get(name, model['sleep_tick_cycles'])
+    ticking = 'TICK_DURING_STANDBY' in macros
+    speed = value(macros, 'STANDBY_TICK_SPEED', 3)
+
+    result = {'mcu': mcu, 'bod': bod}
+    for label, mode, ind_mode in (('off', off_mode, ind & 3),
+                                  ('lockout', lockout_mode, (ind >> 2) & 3)):
+        ua = floor + bod_ua + divider_ua
+        ua += led_ua(macros, mode, ind_mode)
+        wakes = 0.0
+        if ticking:
+            tick_rate = 1.0 / (TICK_SECONDS * (1 << speed))
+            step = 1
+            if 'USE_ADAPTIVE_STANDBY' in macros:
+                step = wake_step(macros, mode, ind_mode, speed, speed_max)
+            wakes = tick_rate / step
+            per_wake = (tick_cycles + model['wake_overhead_cycles']) / f_cpu
+            ua += active_ua * wakes * per_wake / 1e6
+            if 'USE_SLEEP_LVP' in macros:
+                lvp_rate = tick_rate / 64.0
+                ua += active_ua * lvp_rate * model['lvp_cycles'] / f_cpu / 1e6
+                if 'USE_ADC_SLEEP' in macros:
+                    # a junk sample, then one or a burst, with the CPU halted
+                    samples = 1 + (16 if 'USE_ADC_OVERSAMPLING' in macros
+                                   else 1)
+                    adc_ua = model['adc_sleep_ua']
+                    seconds = samples * model['adc_conversion_us'] / 1e6
+                else:
+                    # left on until the next wake-up handles it
+                    adc_ua = model['adc_ua']
+                    seconds = TICK_SECONDS * (1 << speed)
+                ua += adc_ua * lvp_rate * seconds
+        result[label + '_wakes'] = wakes
+        result[label + '_ua'] = ua
+        hours = model['capacity_mah'] * 1000.0 / ua
+        result[label + '_months'] = hours / 24.0 / 30.44
+    return result
+
+
+def report(results, old, threshold, csv):
+    """Prints the results, returns the number of regressions."""
+    columns = ('target', 'mcu', 'bod', 'off wakes/s', 'off uA',
+               'off months', 'lockout uA', 'lockout months')
+    if old is not None:
+        columns += ('was off uA', 'was lockout uA', 'flag')
+    rows = []
+    regressions = 0
+    for name in sorted(results):
+        r = results[name]
+        if r is None:
+            rows.append([name, '?', '?', '-', 'preprocessor error'])
+            continue
+        row = [name, str(r['mcu']), r['bod'],
+               '%.2f' % r['off_wakes'],
+               '%.1f' % r['off_ua'], '%.1f' % r['off_months'],
+               '%.1f' % r['lockout_ua'], '%.1f' % r['lockout_months']]
+        if old is not None:
+            o = old.get(name)
+            if not o:
+                row += ['-', '-', 'new']
+            else:
+                flag = ''
+                for label in ('off', 'lockout'):
+                    was, now = o[label + '_ua'], r[label + '_ua']
+                    if now > was * (1.0 + threshold / 100.0):
+                        flag = 'REGRESSION'
+                    elif now < was * (1.0 - threshold / 100.0) and not flag:
+                        flag = 'better'
+                if flag == 'REGRESSION':
+                    regressions += 1
+                row += ['%.1f' % o['off_ua'], '%.1f' % o['lockout_ua'], flag]
+        rows.append(row)
+
+    print_table(columns, rows, csv)
+    if old is not None and not csv:
+        print('%i regression(s) over %g%%' % (regressions, threshold))
+    return regressions
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
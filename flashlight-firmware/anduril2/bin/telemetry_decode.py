@@ -0,0 +1,142 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import struct
+import sys
+
+from perf_decode import read_dump
+
+# same layout as TelemetryRecord in fsm-telemetry.h (avr-gcc doesn't pad)
+TELEMETRY_MAGIC = 0x7e
+TELEMETRY_BANDS = 4
+TELEMETRY_FORMAT = '<BBH%iIIIHbBB' % TELEMETRY_BANDS
+TELEMETRY_SIZE = struct.calcsize(TELEMETRY_FORMAT)
+
+
+def main(args):
+    """Decodes the usage log (USE_TELEMETRY) from an EEPROM dump.
+
+    Usage: telemetry_decode.py [options] dump_file
+    Options:
+      --all     show every saved copy, not only the newest
+      --csv     print one CSV line per copy instead
+
+    The dump can be raw binary or Intel hex, like from:
+      avrdude -p t1634 -c usbasp -U eeprom:r:eeprom.bin:r
+    The log's position depends on the build's config size, so the dump
+    is searched for copies (slots) with a valid checksum, and the newest
+    one is shown.
+    """
+    show_all = False
+    csv = False
+    path = None
+
+    i = 0
+    while i < len(args):
+        a = args[i]
+        if a == '--all':
+            show_all = True
+        elif a == '--csv':
+            csv = True
+        elif a.startswith('-'):
+            print(main.__doc__)
+            return 2
+        else:
+            path = a
+        i += 1
+    if not path:
+        print(main.__doc__)
+        return 2
+
+    records = find_records(read_dump(path))
+    if not records:
+        print('no usage log found')
+        return 1
+    if not show_all:
+        records = [newest(records)]
+
+    if csv:
+        print('offset,seq,boots,%s,turbo_s,throttle_s,lvp_events,'
+              'max_temp_c,min_volts' % ','.join(
+                  'band%i_s' % (b + 1) for b in range(TELEMETRY_BANDS)))
+        for offset, r in records:
+            print(','.join(str(x) for x in
+                           [offset, r['seq'], r['boots']]
+                           + r['band_seconds']
+                           + [r['turbo_seconds'], r['throttle_seconds'],
+                              r['lvp_events'], temperature(r, ''),
+                              voltage(r, '')]))
+        return 0
+
+    for n, (offset, r) in enumerate(records):
+        if n:
+            print()
+        print('offset           %i (save #%i)' % (offset, r['seq']))
+        print('boots            %i' % r['boots'])
+        on = sum(r['band_seconds'])
+        print('time on          %s' % hms(on))
+        for b, seconds in enumerate(r['band_seconds']):
+            share = (100.0 * seconds / on) if on else 0.0
+            print('  band %i of %i    %s  (%.0f%%)'
+                  % (b + 1, TELEMETRY_BANDS, hms(seconds), share))
+        print('turbo            %s' % hms(r['turbo_seconds']))
+        print('thermal limited  %s' % hms(r['throttle_seconds']))
+        print('LVP events       %i' % r['lvp_events'])
+        print('max temperature  %s' % temperature(r))
+        print('min voltage      %s' % voltage(r))
+    return 0
+
+
+def checksum(data):
+    return (TELEMETRY_MAGIC + sum(data)) & 0xff
+
+
+def find_records(data):
+    """Returns [(offset, record)] for every valid copy in a dump."""
+    found = []
+    for offset in range(len(data) - TELEMETRY_SIZE + 1):
+        chunk = bytes(data[offset:offset + TELEMETRY_SIZE])
+        if bytearray(chunk)[0] != TELEMETRY_MAGIC:
+            continue
+        if checksum(bytearray(chunk[:-1])) != bytearray(chunk)[-1]:
+            continue
+        v = struct.unpack(TELEMETRY_FORMAT, chunk)
+        b = TELEMETRY_BANDS
+        found.append((offset, {
+            'seq': v[1], 'boots': v[2], 'band_seconds': list(v[3:3 + b]),
+            'turbo_seconds': v[3 + b], 'throttle_seconds': v[4 + b],
+            'lvp_events': v[5 + b], 'max_temperature': v[6 + b],
+            'min_voltage': v[7 + b],
+        }))
+    return found
+
+
+def newest(records):
+    """The copy with the highest save number (which wraps at 256)."""
+    best = records[0]
+    for r in records[1:]:
+        if ((r[1]['seq'] - best[1]['seq']) & 0xff) in range(1, 128):
+            best = r
+    return best
+
+
+def hms(seconds):
+    return '%i:%02i:%02i' % (seconds // 3600, (seconds // 60) % 60,
+                             seconds % 60)
+
+
+def temperature(r, unit=' C'):
+    if r['max_temperature'] == -128:  # never measured
+        return 'none' if unit else ''
+    return '%i%s' % (r['max_temperature'], unit)
+
+
+def voltage(r, unit=' V'):
+    if r['min_voltage'] == 255:  # never measured
+        return 'none' if unit else ''
+    return '%.1f%s' % (r['min_voltage'] / 10.0, unit)
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,415 @@
+#!/usr/bin/env python
+
+from __future__ import print_function
+
+import difflib
+import multiprocessing
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from anduril_build import ANDURIL_DIR, build_sim, build_sim_targets, \
+    data_symbol, function_addresses, io_registers, parse_args, \
+    print_table, sim_targets, value
+
+
+def clicks(start, count, hold=0.0):
+    """Button inputs for COUNT quick clicks starting at START seconds,
+    with the last press held for HOLD seconds instead."""
+    inputs = []
+    t = start
+    for n in range(count):
+        down = hold if (hold and n == count - 1) else 0.05
+        inputs += [(round(t, 3), 'press'), (round(t + down, 3), 'release')]
+        t += down + 0.1
+    return inputs
+
+
+# built-in input scripts: name, button inputs, seconds to run
+# (everything starts from off, at least a second after power-on)
+SCENARIOS = (
+    ('click-on-off', clicks(1.0, 1) + clicks(3.0, 1), 5.0),
+    ('hold-ramp', clicks(1.0, 1) + clicks(2.0, 1, hold=2.0)
+     + clicks(5.0, 1), 7.0),
+    ('ceiling', clicks(1.0, 2) + clicks(3.0, 1), 5.0),
+    ('battcheck', clicks(1.0, 3) + clicks(5.0, 1), 7.0),
+    ('lockout', clicks(1.0, 4) + clicks(3.0, 1, hold=1.0)
+     + clicks(5.0, 4) + clicks(7.0, 1), 9.0),
+)
+
+# how far apart two recordings' timestamps can be, in ms
+# (a bit more than one 16 ms clock tick)
+SLACK_MS = 20.0
+
+
+def main(args):
+    """Records what Anduril's UI does for each build target, by running it
+    in simavr (with bin/fsm-sim.c), or replays earlier recordings against
+    the current code and reports what changed.
+
+    Usage: ui_trace.py record|replay [options] [pattern]
+    Options:
+      --dir DIR          where the recordings are (default: traces)
+      --scenario NAME    only this built-in input script (repeatable)
+      --script FILE      also record this input script (repeatable)
+      --volts V          battery voltage (default 3.7)
+      --ticks            keep EV_tick events (normally left out, since
+                         there are 62 per second)
+      --slack MS         timing tolerance for replay (default 20)
+      --diff             show what changed, not only which traces differ
+      --jobs N           builds / simulations at once (default: CPUs)
+
+    Each target is built with USE_EVENT_TRACE, then each input script
+    presses the button at exact times.  The recording, in
+    DIR/<target>/<script>.trace, has every button press and release,
+    every event the UI handles, every state change, and every change to
+    the light's PWM levels, in order, with the time in ms since power-on.
+
+    "replay" reads the button inputs back out of each recording, runs
+    them on the current code, and compares the results.  A recording
+    only differs if something happened in a different order, or more
+    than --slack ms earlier or later.  Exits with status 1 if any
+    recording differs.
+
+    Input scripts have one input per line, like:
+      1.0 press
+      1.05 release
+      end 3.0
+    (times are in seconds, and "end" is when to stop)
+    The built-in scripts are: %s
+
+    Needs avr-gcc, simavr, and libelf.  The attiny1616 family isn't
+    supported by simavr, so those targets are skipped.
+    """
+    main.__doc__ = main.__doc__ % ', '.join(s[0] for s in SCENARIOS)
+    if not args or args[0] not in ('record', 'replay'):
+        print(main.__doc__)
+        return 2
+    command = args[0]
+    opts = parse_args(args[1:], {
+        '--dir': ('dir', str, 'traces'),
+        '--scenario': ('only', str, []),
+        '--script': ('scripts', str, []),
+        '--volts': ('volts', float, 3.7),
+        '--ticks': ('ticks', None, False),
+        '--slack': ('slack', float, SLACK_MS),
+        '--diff': ('diff', None, False),
+        '--jobs': ('jobs', int, multiprocessing.cpu_count()),
+        }, main.__doc__)
+    if opts is None:
+        return 2
+    only = opts['only']
+    ticks = opts['ticks']
+    jobs = opts['jobs']
+    trace_dir = os.path.abspath(opts['dir'])
+
+    # what to run on each target: {script name: (inputs, seconds)}
+    # (for replay, that comes from each target's recordings instead)
+    scenarios = {}
+    if command == 'record':
+        for name, inputs, seconds in SCENARIOS:
+            if (not only) or (name in only):
+                scenarios[name] = (inputs, seconds)
+        for path in opts['scripts']:
+            name = os.path.splitext(os.path.basename(path))[0]
+            try:
+                scenarios[name] = read_script(path)
+            except ValueError as e:
+                print('%s: %s' % (path, e))
+                return 2
+        if not scenarios:
+            print('no such scenario: %s' % ', '.join(only))
+            return 2
+
+    tmp = tempfile.mkdtemp()
+    try:
+        sim = build_sim(tmp)
+        if not sim:
+            return 2
+        targets = find_targets(ANDURIL_DIR, opts['pattern'])
+        if command == 'replay':
+            targets = dict((name, t) for name, t in targets.items()
+                           if os.path.isdir(os.path.join(trace_dir, name)))
+            if not targets:
+                print('no recordings in %s' % trace_dir)
+                return 2
+        build_targets(ANDURIL_DIR, targets, tmp, jobs)
+
+        # every (target, script) pair runs on its own
+        runs = []
+        for name in sorted(targets):
+            t = targets[name]
+            if 'error' in t:
+                continue
+            if command == 'record':
+                todo = scenarios
+            else:
+                todo = recorded_scenarios(os.path.join(trace_dir, name),
+                                          only)
+            for script in sorted(todo):
+                inputs, seconds = todo[script]
+                trace = os.path.join(tmp, '%s.%s.trace' % (name, script))
+                cmd = sim_command(sim, t, inputs, seconds, opts['volts'],
+                                  trace)
+                runs.append((name, script, seconds, (cmd, trace)))
+        outputs = run_all([run for _, _, _, run in runs], jobs)
+    finally:
+        shutil.rmtree(tmp)
+
+    results = []
+    for name in sorted(targets):
+        if 'error' in targets[name]:
+            results.append((name, '-', targets[name]['error'], None))
+    for (name, script, seconds, _), (status, out) in zip(runs, outputs):
+        if status:
+            results.append((name, script, out.strip() or 'simulator failed',
+                            None))
+            continue
+        lines = name_trace(out, targets[name], seconds, ticks)
+        path = os.path.join(trace_dir, name, script + '.trace')
+        if command == 'record':
+            if not os.path.isdir(os.path.dirname(path)):
+                os.makedirs(os.path.dirname(path))
+            with open(path, 'w') as fp:
+                fp.write('# %s %s\n' % (name, script))
+                for line in lines:
+                    fp.write(line + '\n')
+            results.append((name, script, 'recorded %i lines' % len(lines),
+                            None))
+        else:
+            with open(path) as fp:
+                old = [line.rstrip('\n') for line in fp
+                       if not line.startswith('#')]
+            if not ticks:
+                old = [line for line in old if ' event EV_tick ' not in line]
+            diff = compare(old, lines, opts['slack'])
+            results.append((name, script, 'DIFF' if diff else 'same', diff))
+
+    return report(results, opts['diff'])
+
+
+def read_script(path):
+    """Reads an input script, returns (inputs, seconds)."""
+    inputs = []
+    seconds = None
+    with open(path) as fp:
+        for line in fp:
+            parts = line.split('#')[0].split()
+            if not parts:
+                continue
+            if parts[0] == 'end' and len(parts) == 2:
+                seconds = float(parts[1])
+            elif len(parts) == 2 and parts[1] in ('press', 'release'):
+                inputs.append((float(parts[0]), parts[1]))
+            else:
+                raise ValueError('bad line: %s' % line.strip())
+    check_inputs(inputs)
+    if seconds is None:
+        seconds = (inputs[-1][0] if inputs else 0.0) + 2.0
+    return inputs, seconds
+
+
+def check_inputs(inputs):
+    """The simulator takes a list of times: press, release, press..."""
+    for n, (t, action) in enumerate(inputs):
+        if action != ('release' if n & 1 else 'press'):
+            raise ValueError('presses and releases must alternate')
+        if n and t <= inputs[n - 1][0]:
+            raise ValueError('inputs must be in order')
+
+
+def recorded_scenarios(target_dir, only):
+    """Returns {script name: (inputs, seconds)} from a target's recordings,
+    using the button inputs and end time in each one."""
+    scenarios = {}
+    for f in sorted(os.listdir(target_dir)):
+        name, ext = os.path.splitext(f)
+        if ext != '.trace' or (only and name not in only):
+            continue
+        inputs = []
+        seconds = 0.0
+        with open(os.path.join(target_dir, f)) as fp:
+            for line in fp:
+                parts = line.split()
+                if len(parts) != 2 or line.startswith('#'):
+                    continue
+                t = float(parts[0]) / 1000.0
+                if parts[1] in ('press', 'release'):
+                    inputs.append((t, parts[1]))
+                elif parts[1] == 'end':
+                    seconds = t
+        scenarios[name] = (inputs, seconds)
+    return scenarios
+
+
+def find_targets(anduril_dir, pattern):
+    """Returns {target: info} for every matching cfg file, with what's
+    needed to simulate it and to put names on its trace."""
+    targets = sim_targets(anduril_dir, pattern)
+    for name in sorted(targets):
+        t = targets[name]
+        if 'error' in t:
+            continue
+        macros = t['macros']
+        switch = re.match(r'^P([A-Z])(\d)$', macros.get('SWITCH_PIN', ''))
+        if not switch:
+            t['error'] = 'no switch pin'
+            continue
+        t['switch'] = '%s:%s' % switch.groups()
+        t['f_cpu'] = value(macros, 'F_CPU', 8000000)
+        t['events'] = event_names(macros)
+        # light output registers, and what to call them
+        t['lights'] = {}
+        registers = io_registers(t['mcu'])
+        for n in range(1, 5):
+            reg = macros.get('PWM%i_LVL' % n)
+            if reg not in registers:
+                continue
+            addr, size = registers[reg]
+            for b in range(size):
+                t['lights'][addr + b] = 'PWM%i_LVL%s' % (
+                    n, ':hi' if b else '')
+    return targets
+
+
+def event_names(macros):
+    """Returns {event number: name} for the FSM's EV_* macros."""
+    names = {}
+    for name in macros:
+        if not name.startswith('EV_'):
+            continue
+        v = value(macros, name)
+        if not isinstance(v, int):
+            continue
+        # for aliases, like EV_hold and EV_click1_hold, use the long one
+        old = names.get(v)
+        if old is None or (-len(name), name) < (-len(old), old):
+            names[v] = name
+    return names
+
+
+def build_targets(anduril_dir, targets, tmp, jobs):
+    """Builds the targets with USE_EVENT_TRACE, all at once, then finds
+    each one's trace ring."""
+    build_sim_targets(anduril_dir, targets, os.path.join(tmp, 'build'),
+                      ['-DUSE_EVENT_TRACE'], jobs)
+    for name in sorted(targets):
+        t = targets[name]
+        if 'error' in t:
+            continue
+        ring = data_symbol(t['elf'], 'event_trace')
+        if not ring:
+            t['error'] = 'no event_trace in the build'
+            continue
+        addr, size = ring
+        t['ring'] = '%i:%i' % (addr, (size - 1) // 3)
+        t['states'] = dict((a, s) for s, a in
+                           function_addresses(t['elf']).items())
+
+
+def sim_command(sim, t, inputs, seconds, volts, trace):
+    cmd = [sim, '-m', 'attiny%i' % t['mcu'], '-f', str(t['f_cpu']),
+           '-s', t['switch'], '-v', str(int(volts * 1000)),
+           '-E', t['ring'], '-T', trace, '-t', str(seconds)]
+    for addr in sorted(t['lights']):
+        cmd += ['-w', str(addr)]
+    if inputs:
+        cmd += ['-b', ','.join('%g' % when for when, _ in inputs)]
+    cmd.append(t['elf'])
+    return cmd
+
+
+def run_sim(run):
+    """Returns (exit status, trace or error message)."""
+    cmd, trace = run
+    proc = subprocess.Popen(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.PIPE)
+    _, err = proc.communicate()
+    if proc.returncode:
+        return proc.returncode, err.decode()
+    with open(trace) as fp:
+        return 0, fp.read()
+
+
+def run_all(runs, jobs):
+    if jobs <= 1 or len(runs) <= 1:
+        return [run_sim(run) for run in runs]
+    pool = multiprocessing.Pool(jobs)
+    try:
+        return pool.map(run_sim, runs)
+    finally:
+        pool.close()
+
+
+def name_trace(out, t, seconds, ticks):
+    """Turns fsm-sim's trace into the recorded form, with names for
+    events, states, and light registers, and the end time last."""
+    lines = []
+    for line in out.splitlines():
+        parts = line.split()
+        if len(parts) < 2:
+            continue
+        when = parts[0]
+        if parts[1] in ('press', 'release'):
+            lines.append('%s %s' % (when, parts[1]))
+        elif parts[1] == 'light' and len(parts) == 4:
+            addr = int(parts[2], 0)
+            lines.append('%s light %s %s' % (
+                when, t['lights'].get(addr, parts[2]), parts[3]))
+        elif parts[1] == 'event' and len(parts) == 4:
+            event = t['events'].get(int(parts[2]), 'event_%s' % parts[2])
+            if event == 'EV_tick' and not ticks:
+                continue
+            lines.append('%s event %s %s' % (when, event, parts[3]))
+        elif parts[1] == 'state' and len(parts) == 3:
+            addr = int(parts[2], 0)
+            state = t['states'].get(addr, parts[2]) if addr else 'none'
+            lines.append('%s state %s' % (when, state))
+    lines.append('%.3f end' % (seconds * 1000.0))
+    return lines
+
+
+def compare(old, new, slack, labels=('recorded', 'replayed')):
+    """Returns a list of diff lines, or [] if they match."""
+    def split(lines):
+        return [line.split(' ', 1) for line in lines]
+    old_parts, new_parts = split(old), split(new)
+    # the "end" line depends on how long it ran, not on the UI
+    old_what = [p[1] for p in old_parts if p[-1] != 'end']
+    new_what = [p[1] for p in new_parts if p[-1] != 'end']
+    if old_what != new_what:
+        return list(difflib.unified_diff(old_what, new_what, labels[0],
+                                         labels[1], lineterm='', n=2))
+    diff = []
+    for o, n in zip(old_parts, new_parts):
+        if o[-1] == 'end':
+            continue
+        if abs(float(o[0]) - float(n[0])) > slack:
+            diff.append('%s: was at %s ms, now at %s ms' % (o[1], o[0], n[0]))
+    return diff
+
+
+def report(results, show_diff):
+    """Prints the results, returns the exit status."""
+    print_table(['target', 'script', 'result'],
+                [[name, script, result]
+                 for name, script, result, _ in sorted(results)])
+    status = 0
+    for name, script, result, diff in sorted(results):
+        if (result != 'same') and not result.startswith('recorded'):
+            status = 1
+        if diff and show_diff:
+            print()
+            print('%s %s:' % (name, script))
+            for line in diff[:40]:
+                print('  ' + line)
+            if len(diff) > 40:
+                print('  ... (%i more)' % (len(diff) - 40))
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))